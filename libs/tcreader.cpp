@@ -3,28 +3,55 @@
 //===================================================================
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <cstdarg>
+#include <cstddef>
 #include <cstring>
+#include <ctime>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <numeric>
+#include <set>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <vector>
+#include <cfloat>
 #include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include <archive.h>
 #include <archive_entry.h>
 #include <filesystem>
 #include <termios.h>
 #include <signal.h>
+#include <zlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
@@ -34,7 +61,7 @@
 namespace fs = std::filesystem;
 
 // ------------------------------------------------------------------
-// Simple JSON writer for progress tracking
+// Reader for the old name‑keyed progress file (see ProgressStore)
 // ------------------------------------------------------------------
 class SimpleJSON {
 public:
@@ -59,56 +86,818 @@ public:
             }
         }
     }
+};
 
-    void save(const std::string& path) {
-        std::ofstream file(path);
-        if (!file.is_open()) return;
+// ------------------------------------------------------------------
+// Pixel kernels with per‑CPU variants. x86 variants are built with
+// target attributes and picked from cpuid at first use, ARM ones from
+// the hwcaps, so one binary makes the most of each machine. The
+// TCREADER_KERNELS environment variable (a list such as "sse2,ssse3")
+// limits the choice, and `tcreader --kernels` shows what was picked.
+// ------------------------------------------------------------------
+namespace kern {
+static const char base64_alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-        file << "{\n";
-        bool first = true;
-        for (const auto& [key, val] : data) {
-            if (!first) file << ",\n";
-            file << "  \"" << key << "\": " << val;
-            first = false;
-        }
-        file << "\n}\n";
+// acc[i] += weight * src[i] over a row of bytes. Accumulators are 16‑bit,
+// so the taps are 8‑bit weights summing to 256.
+using TapFn = void (*)(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight);
+// Base64 of a prefix of whole 3‑byte groups; returns the bytes consumed
+// (SIMD variants leave a short tail for the scalar one)
+using Base64Fn = size_t (*)(const unsigned char* src, size_t len, char* dst);
+// Index of the nearest of n palette colours. The planar arrays hold 256
+// entries; those past n must be far away from any colour.
+using NearestFn = int (*)(const float* r, const float* g, const float* b, int n,
+                          float pr, float pg, float pb);
+
+static void tap_scalar(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight) {
+    for (size_t i = 0; i < n; ++i) acc[i] = static_cast<uint16_t>(acc[i] + weight * src[i]);
+}
+
+static size_t base64_scalar(const unsigned char* src, size_t len, char* dst) {
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3, dst += 4) {
+        uint32_t v = static_cast<uint32_t>(src[i]) << 16 | src[i + 1] << 8 | src[i + 2];
+        dst[0] = base64_alphabet[v >> 18];
+        dst[1] = base64_alphabet[(v >> 12) & 63];
+        dst[2] = base64_alphabet[(v >> 6) & 63];
+        dst[3] = base64_alphabet[v & 63];
+    }
+    return i;
+}
+
+static int nearest_scalar(const float* r, const float* g, const float* b, int n,
+                          float pr, float pg, float pb) {
+    int best = 0;
+    float best_d = FLT_MAX;
+    for (int i = 0; i < n; ++i) {
+        float dr = r[i] - pr, dg = g[i] - pg, db = b[i] - pb;
+        float d = dr * dr + dg * dg + db * db;
+        if (d < best_d) { best_d = d; best = i; }
+    }
+    return best;
+}
+
+// Lowest index among the lanes holding the smallest distance
+static int nearest_reduce(const float* d, const int32_t* idx, int lanes) {
+    int best = 0;
+    for (int l = 1; l < lanes; ++l)
+        if (d[l] < d[best] || (d[l] == d[best] && idx[l] < idx[best])) best = l;
+    return idx[best];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2")))
+static void tap_sse2(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight) {
+    const __m128i w = _mm_set1_epi16(static_cast<short>(weight)), zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi16(_mm_loadu_si128(a),
+                                          _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), w)));
+        _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1),
+                                              _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), w)));
+    }
+    tap_scalar(acc + i, src + i, n - i, weight);
+}
+
+__attribute__((target("avx2")))
+static void tap_avx2(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight) {
+    const __m256i w = _mm256_set1_epi16(static_cast<short>(weight));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+        _mm256_storeu_si256(a, _mm256_add_epi16(_mm256_loadu_si256(a), _mm256_mullo_epi16(v, w)));
+    }
+    tap_scalar(acc + i, src + i, n - i, weight);
+}
+
+__attribute__((target("avx512bw")))
+static void tap_avx512(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight) {
+    const __m512i w = _mm512_set1_epi16(static_cast<short>(weight));
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i v = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        _mm512_storeu_si512(acc + i, _mm512_add_epi16(_mm512_loadu_si512(acc + i),
+                                                      _mm512_mullo_epi16(v, w)));
+    }
+    tap_scalar(acc + i, src + i, n - i, weight);
+}
+
+// Base64 after Muła and Lemire: a shuffle spreads each 3 bytes over a
+// 32‑bit lane, two multiplies move the four 6‑bit fields into place, and
+// a 16‑entry table gives the offset from field value to ASCII.
+__attribute__((target("ssse3")))
+static size_t base64_ssse3(const unsigned char* src, size_t len, char* dst) {
+    const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 12, dst += 16) {   // reads 16, uses 12
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)),
+                                      spread);
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                                     _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                                     _mm_set1_epi32(0x01000010));
+        __m128i fields = _mm_or_si128(hi, lo);
+        __m128i k = _mm_subs_epu8(fields, _mm_set1_epi8(51));
+        k = _mm_or_si128(k, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), fields),
+                                          _mm_set1_epi8(13)));
+        __m128i out = _mm_add_epi8(_mm_shuffle_epi8(offsets, k), fields);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t base64_avx2(const unsigned char* src, size_t len, char* dst) {
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    for (; i + 28 <= len; i += 24, dst += 32) {   // two 12‑byte groups, one per lane
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, spread);
+        __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                                        _mm256_set1_epi32(0x04000040));
+        __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                                        _mm256_set1_epi32(0x01000010));
+        __m256i fields = _mm256_or_si256(hi, lo);
+        __m256i k = _mm256_subs_epu8(fields, _mm256_set1_epi8(51));
+        k = _mm256_or_si256(k, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), fields),
+                                                _mm256_set1_epi8(13)));
+        __m256i out = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, k), fields);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static int nearest_sse2(const float* r, const float* g, const float* b, int n,
+                        float pr, float pg, float pb) {
+    const __m128 vr = _mm_set1_ps(pr), vg = _mm_set1_ps(pg), vb = _mm_set1_ps(pb);
+    __m128 best = _mm_set1_ps(FLT_MAX);
+    __m128i best_i = _mm_setzero_si128(), idx = _mm_setr_epi32(0, 1, 2, 3);
+    for (int i = 0; i < n; i += 4) {
+        __m128 dr = _mm_sub_ps(_mm_loadu_ps(r + i), vr);
+        __m128 dg = _mm_sub_ps(_mm_loadu_ps(g + i), vg);
+        __m128 db = _mm_sub_ps(_mm_loadu_ps(b + i), vb);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+        __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+        best = _mm_min_ps(d, best);
+        best_i = _mm_or_si128(_mm_and_si128(closer, idx), _mm_andnot_si128(closer, best_i));
+        idx = _mm_add_epi32(idx, _mm_set1_epi32(4));
+    }
+    alignas(16) float d[4];
+    alignas(16) int32_t lane[4];
+    _mm_store_ps(d, best);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane), best_i);
+    return nearest_reduce(d, lane, 4);
+}
+
+__attribute__((target("avx2")))
+static int nearest_avx2(const float* r, const float* g, const float* b, int n,
+                        float pr, float pg, float pb) {
+    const __m256 vr = _mm256_set1_ps(pr), vg = _mm256_set1_ps(pg), vb = _mm256_set1_ps(pb);
+    __m256 best = _mm256_set1_ps(FLT_MAX);
+    __m256i best_i = _mm256_setzero_si256(), idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (int i = 0; i < n; i += 8) {
+        __m256 dr = _mm256_sub_ps(_mm256_loadu_ps(r + i), vr);
+        __m256 dg = _mm256_sub_ps(_mm256_loadu_ps(g + i), vg);
+        __m256 db = _mm256_sub_ps(_mm256_loadu_ps(b + i), vb);
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg)),
+                                 _mm256_mul_ps(db, db));
+        __m256 closer = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+        best = _mm256_min_ps(d, best);
+        best_i = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_i),
+                                                      _mm256_castsi256_ps(idx), closer));
+        idx = _mm256_add_epi32(idx, _mm256_set1_epi32(8));
+    }
+    alignas(32) float d[8];
+    alignas(32) int32_t lane[8];
+    _mm256_store_ps(d, best);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane), best_i);
+    return nearest_reduce(d, lane, 8);
+}
+#endif
+
+#if defined(__aarch64__)
+static void tap_neon(uint16_t* acc, const unsigned char* src, size_t n, unsigned weight) {
+    const uint8x8_t w = vdup_n_u8(static_cast<uint8_t>(weight));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(src + i);
+        vst1q_u16(acc + i, vmlal_u8(vld1q_u16(acc + i), vget_low_u8(v), w));
+        vst1q_u16(acc + i + 8, vmlal_u8(vld1q_u16(acc + i + 8), vget_high_u8(v), w));
+    }
+    tap_scalar(acc + i, src + i, n - i, weight);
+}
+
+// vld3 splits 48 bytes into the 1st, 2nd and 3rd byte of each group;
+// the four 6‑bit fields then index a 64‑byte table lookup
+static size_t base64_neon(const unsigned char* src, size_t len, char* dst) {
+    const uint8_t* alphabet = reinterpret_cast<const uint8_t*>(base64_alphabet);
+    const uint8x16x4_t table = { { vld1q_u8(alphabet), vld1q_u8(alphabet + 16),
+                                   vld1q_u8(alphabet + 32), vld1q_u8(alphabet + 48) } };
+    const uint8x16_t low6 = vdupq_n_u8(0x3f);
+    size_t i = 0;
+    for (; i + 48 <= len; i += 48, dst += 64) {
+        uint8x16x3_t in = vld3q_u8(src + i);
+        uint8x16x4_t out;
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vorrq_u8(vshrq_n_u8(in.val[1], 4), vandq_u8(vshlq_n_u8(in.val[0], 4), low6));
+        out.val[2] = vorrq_u8(vshrq_n_u8(in.val[2], 6), vandq_u8(vshlq_n_u8(in.val[1], 2), low6));
+        out.val[3] = vandq_u8(in.val[2], low6);
+        for (int k = 0; k < 4; ++k) out.val[k] = vqtbl4q_u8(table, out.val[k]);
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst), out);
+    }
+    return i;
+}
+
+static int nearest_neon(const float* r, const float* g, const float* b, int n,
+                        float pr, float pg, float pb) {
+    static const int32_t first[4] = { 0, 1, 2, 3 };
+    const float32x4_t vr = vdupq_n_f32(pr), vg = vdupq_n_f32(pg), vb = vdupq_n_f32(pb);
+    float32x4_t best = vdupq_n_f32(FLT_MAX);
+    int32x4_t best_i = vdupq_n_s32(0), idx = vld1q_s32(first);
+    for (int i = 0; i < n; i += 4) {
+        float32x4_t dr = vsubq_f32(vld1q_f32(r + i), vr);
+        float32x4_t dg = vsubq_f32(vld1q_f32(g + i), vg);
+        float32x4_t db = vsubq_f32(vld1q_f32(b + i), vb);
+        float32x4_t d = vaddq_f32(vaddq_f32(vmulq_f32(dr, dr), vmulq_f32(dg, dg)), vmulq_f32(db, db));
+        uint32x4_t closer = vcltq_f32(d, best);
+        best = vminq_f32(d, best);
+        best_i = vbslq_s32(closer, idx, best_i);
+        idx = vaddq_s32(idx, vdupq_n_s32(4));
     }
+    float d[4];
+    int32_t lane[4];
+    vst1q_f32(d, best);
+    vst1q_s32(lane, best_i);
+    return nearest_reduce(d, lane, 4);
+}
+#endif
+
+template <typename Fn> struct Variant { const char* isa; Fn fn; };
+
+// Best first; "scalar" always last
+static const Variant<TapFn> tap_variants[] = {
+#if defined(__x86_64__) || defined(__i386__)
+    { "avx512bw", tap_avx512 }, { "avx2", tap_avx2 }, { "sse2", tap_sse2 },
+#elif defined(__aarch64__)
+    { "neon", tap_neon },
+#endif
+    { "scalar", tap_scalar },
+};
+static const Variant<Base64Fn> base64_variants[] = {
+#if defined(__x86_64__) || defined(__i386__)
+    { "avx2", base64_avx2 }, { "ssse3", base64_ssse3 },
+#elif defined(__aarch64__)
+    { "neon", base64_neon },
+#endif
+    { "scalar", base64_scalar },
+};
+static const Variant<NearestFn> nearest_variants[] = {
+#if defined(__x86_64__) || defined(__i386__)
+    { "avx2", nearest_avx2 }, { "sse2", nearest_sse2 },
+#elif defined(__aarch64__)
+    { "neon", nearest_neon },
+#endif
+    { "scalar", nearest_scalar },
+};
+
+// Whether this CPU runs `isa` (__builtin_cpu_supports wants literals)
+static bool cpu_has(const std::string& isa) {
+    if (isa == "scalar") return true;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (isa == "sse2") return __builtin_cpu_supports("sse2");
+    if (isa == "ssse3") return __builtin_cpu_supports("ssse3");
+    if (isa == "avx2") return __builtin_cpu_supports("avx2");
+    if (isa == "avx512bw") return __builtin_cpu_supports("avx512bw");
+#elif defined(__aarch64__)
+    if (isa == "neon") return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#endif
+    return false;
+}
+
+static bool allowed(const std::string& isa) {
+    const char* env = getenv("TCREADER_KERNELS");
+    if (!env || !*env || isa == "scalar") return true;
+    std::stringstream list(env);
+    std::string item;
+    while (std::getline(list, item, ','))
+        if (item == isa) return true;
+    return false;
+}
+
+template <typename Fn, size_t N>
+static Variant<Fn> pick(const Variant<Fn> (&variants)[N]) {
+    for (const Variant<Fn>& v : variants)
+        if (cpu_has(v.isa) && allowed(v.isa)) return v;
+    return variants[N - 1];
+}
+
+// ISA stb_image_resize2 was compiled for (it has no runtime dispatch)
+static const char* resize_isa() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__) || defined(__x86_64__)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+} // namespace kern
+
+struct Kernels {
+    kern::Variant<kern::TapFn> tap;
+    kern::Variant<kern::Base64Fn> base64;
+    kern::Variant<kern::NearestFn> nearest;
 };
 
+const Kernels& kernels() {
+    static const Kernels k = { kern::pick(kern::tap_variants), kern::pick(kern::base64_variants),
+                               kern::pick(kern::nearest_variants) };
+    return k;
+}
+
 // ------------------------------------------------------------------
 // Base64 encoding for Kitty graphics protocol
 // ------------------------------------------------------------------
-static const char base64_chars[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 std::string base64_encode(const unsigned char* data, size_t len) {
-    std::string ret;
-    int i = 0, j = 0;
-    unsigned char arr3[3], arr4[4];
-
-    while (len--) {
-        arr3[i++] = *(data++);
-        if (i == 3) {
-            arr4[0] = (arr3[0] & 0xfc) >> 2;
-            arr4[1] = ((arr3[0] & 0x03) << 4) + ((arr3[1] & 0xf0) >> 4);
-            arr4[2] = ((arr3[1] & 0x0f) << 2) + ((arr3[2] & 0xc0) >> 6);
-            arr4[3] = arr3[2] & 0x3f;
-            for (i = 0; i < 4; i++) ret += base64_chars[arr4[i]];
-            i = 0;
-        }
-    }
-
-    if (i) {
-        for (j = i; j < 3; j++) arr3[j] = '\0';
-        arr4[0] = (arr3[0] & 0xfc) >> 2;
-        arr4[1] = ((arr3[0] & 0x03) << 4) + ((arr3[1] & 0xf0) >> 4);
-        arr4[2] = ((arr3[1] & 0x0f) << 2) + ((arr3[2] & 0xc0) >> 6);
-        for (j = 0; j < i + 1; j++) ret += base64_chars[arr4[j]];
-        while (i++ < 3) ret += '=';
+    std::string ret((len + 2) / 3 * 4, '\0');
+    size_t done = kernels().base64.fn(data, len, &ret[0]);
+    done += kern::base64_scalar(data + done, len - done, &ret[done / 3 * 4]);
+    if (size_t rest = len - done) {
+        const char* alphabet = kern::base64_alphabet;
+        char* out = &ret[done / 3 * 4];
+        uint32_t v = static_cast<uint32_t>(data[done]) << 16 | (rest > 1 ? data[done + 1] << 8 : 0);
+        out[0] = alphabet[v >> 18];
+        out[1] = alphabet[(v >> 12) & 63];
+        out[2] = rest > 1 ? alphabet[(v >> 6) & 63] : '=';
+        out[3] = '=';
     }
     return ret;
 }
 
+// ------------------------------------------------------------------
+// printf‑style formatting into a std::string
+// ------------------------------------------------------------------
+std::string strfmt(const char* fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return "";
+    if (static_cast<size_t>(n) < sizeof(buf)) return std::string(buf, n);
+
+    std::string out(n, '\0');
+    va_start(ap, fmt);
+    vsnprintf(&out[0], n + 1, fmt, ap);
+    va_end(ap);
+    return out;
+}
+
+// ------------------------------------------------------------------
+// Minimal PNG encoder (backends that need a re-encoded image, repack)
+// ------------------------------------------------------------------
+static void png_put_u32(std::vector<unsigned char>& out, uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v >> 24));
+    out.push_back(static_cast<unsigned char>(v >> 16));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+static void png_put_chunk(std::vector<unsigned char>& out, const char* type,
+                          const unsigned char* data, size_t len) {
+    png_put_u32(out, static_cast<uint32_t>(len));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (len) out.insert(out.end(), data, data + len);
+    uLong crc = crc32(0L, out.data() + start, static_cast<uInt>(len + 4));
+    png_put_u32(out, static_cast<uint32_t>(crc));
+}
+
+// Row filter `type` applied to one scanline (PNG spec, section 9)
+static void png_filter_row(int type, const unsigned char* row, const unsigned char* prev,
+                           size_t stride, int bpp, unsigned char* out) {
+    for (size_t i = 0; i < stride; ++i) {
+        int a = i >= static_cast<size_t>(bpp) ? row[i - bpp] : 0;
+        int b = prev ? prev[i] : 0;
+        int c = prev && i >= static_cast<size_t>(bpp) ? prev[i - bpp] : 0;
+        int pred = 0;
+        switch (type) {
+            case 1: pred = a; break;
+            case 2: pred = b; break;
+            case 3: pred = (a + b) / 2; break;
+            case 4: {
+                int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                break;
+            }
+        }
+        out[i] = static_cast<unsigned char>(row[i] - pred);
+    }
+}
+
+// Deflate filtered scanlines `raw` and wrap them in IHDR/PLTE/IDAT/IEND
+static std::vector<unsigned char> png_assemble(const std::vector<unsigned char>& raw,
+                                               int w, int h, int color_type, int level,
+                                               const unsigned char* palette = nullptr,
+                                               int colors = 0) {
+    uLongf zlen = compressBound(static_cast<uLong>(raw.size()));
+    std::vector<unsigned char> z(zlen);
+    if (compress2(z.data(), &zlen, raw.data(), static_cast<uLong>(raw.size()), level) != Z_OK)
+        return {};
+
+    std::vector<unsigned char> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    std::vector<unsigned char> ihdr;
+    png_put_u32(ihdr, static_cast<uint32_t>(w));
+    png_put_u32(ihdr, static_cast<uint32_t>(h));
+    ihdr.push_back(8);                          // bit depth
+    ihdr.push_back(static_cast<unsigned char>(color_type));
+    ihdr.push_back(0);                          // compression
+    ihdr.push_back(0);                          // filter
+    ihdr.push_back(0);                          // interlace
+    png_put_chunk(out, "IHDR", ihdr.data(), ihdr.size());
+    if (palette) png_put_chunk(out, "PLTE", palette, static_cast<size_t>(colors) * 3);
+    png_put_chunk(out, "IDAT", z.data(), zlen);
+    png_put_chunk(out, "IEND", nullptr, 0);
+    return out;
+}
+
+// best=false: filter None and fastest deflate (for sending to a terminal).
+// best=true: per‑row filter picked by the usual minimum‑sum heuristic and
+// maximum compression (for files that are kept, e.g. `tcreader repack`).
+std::vector<unsigned char> encode_png(const unsigned char* pixels,
+                                      int w, int h, int channels, bool best = false) {
+    static const unsigned char color_types[] = { 0, 0, 4, 2, 6 };
+    if (channels < 1 || channels > 4) return {};
+
+    size_t stride = static_cast<size_t>(w) * channels;
+    std::vector<unsigned char> raw((stride + 1) * h);
+    std::vector<unsigned char> trial(stride);
+    for (int y = 0; y < h; ++y) {
+        unsigned char* dst = &raw[y * (stride + 1)];
+        const unsigned char* row = pixels + y * stride;
+        dst[0] = 0;
+        memcpy(dst + 1, row, stride);
+        if (!best) continue;
+
+        const unsigned char* prev = y > 0 ? row - stride : nullptr;
+        uint64_t best_sum = UINT64_MAX;
+        for (int type = 0; type <= 4; ++type) {
+            png_filter_row(type, row, prev, stride, channels, trial.data());
+            uint64_t sum = 0;
+            for (unsigned char v : trial) sum += v < 128 ? v : 256 - v;
+            if (sum < best_sum) {
+                best_sum = sum;
+                dst[0] = static_cast<unsigned char>(type);
+                memcpy(dst + 1, trial.data(), stride);
+            }
+        }
+    }
+
+    return png_assemble(raw, w, h, color_types[channels],
+                        best ? Z_BEST_COMPRESSION : Z_BEST_SPEED);
+}
+
+// 8‑bit indexed PNG (colour type 3) from one palette index per pixel
+std::vector<unsigned char> encode_png_indexed(const unsigned char* indices, int w, int h,
+                                              const unsigned char* palette, int colors) {
+    size_t stride = static_cast<size_t>(w);
+    std::vector<unsigned char> raw((stride + 1) * h);
+    for (int y = 0; y < h; ++y) {
+        raw[y * (stride + 1)] = 0;
+        memcpy(&raw[y * (stride + 1) + 1], indices + y * stride, stride);
+    }
+    return png_assemble(raw, w, h, 3, Z_BEST_SPEED, palette, colors);
+}
+
+// ------------------------------------------------------------------
+// Palette quantization for slow links. Comic pages get by on a few
+// hundred colours, and one index byte per pixel deflates far better
+// than RGB. Colours are binned at 5 bits per channel from a subsample,
+// split by median cut, refined by a few k‑means passes over the bins,
+// and mapped back through a lazily filled inverse colour map, so most
+// pixels cost a single table lookup.
+// ------------------------------------------------------------------
+namespace quant {
+constexpr int BINS = 1 << 15;
+
+inline int bin_of(int r, int g, int b) { return ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3); }
+
+struct Bin { uint32_t n = 0; double r = 0, g = 0, b = 0; };   // count and mean colour
+
+// Nearest palette entry (a SIMD kernel). Unused entries sit far outside
+// the colour cube so the kernels can always compare whole vectors.
+struct Nearest {
+    int size = 0;
+    float r[256], g[256], b[256];
+
+    Nearest() {
+        std::fill(r, r + 256, 1e9f);
+        std::fill(g, g + 256, 1e9f);
+        std::fill(b, b + 256, 1e9f);
+    }
+
+    int operator()(float pr, float pg, float pb) const {
+        return kernels().nearest.fn(r, g, b, size, pr, pg, pb);
+    }
+};
+
+// Split the used bins into at most `colors` boxes by median cut,
+// always splitting the box with the most pixels × widest extent
+static std::vector<std::vector<int>> median_cut(const std::vector<Bin>& bins,
+                                                std::vector<int> used, int colors) {
+    std::vector<std::vector<int>> boxes;
+    boxes.push_back(std::move(used));
+    auto channel = [&](int i, int c) -> float {
+        return static_cast<float>(c == 0 ? bins[i].r : c == 1 ? bins[i].g : bins[i].b);
+    };
+
+    while (static_cast<int>(boxes.size()) < colors) {
+        int pick = -1, axis = 0;
+        double best = 0;
+        for (size_t k = 0; k < boxes.size(); ++k) {
+            if (boxes[k].size() < 2) continue;
+            float lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+            uint64_t weight = 0;
+            for (int i : boxes[k]) {
+                weight += bins[i].n;
+                for (int c = 0; c < 3; ++c) {
+                    lo[c] = std::min(lo[c], channel(i, c));
+                    hi[c] = std::max(hi[c], channel(i, c));
+                }
+            }
+            int widest = 0;
+            for (int c = 1; c < 3; ++c)
+                if (hi[c] - lo[c] > hi[widest] - lo[widest]) widest = c;
+            double score = static_cast<double>(weight) * (hi[widest] - lo[widest]);
+            if (score > best) { best = score; pick = static_cast<int>(k); axis = widest; }
+        }
+        if (pick < 0) break;
+
+        std::vector<int>& box = boxes[pick];
+        std::sort(box.begin(), box.end(),
+                  [&](int a, int b) { return channel(a, axis) < channel(b, axis); });
+        uint64_t total = 0, acc = 0;
+        for (int i : box) total += bins[i].n;
+        size_t cut = 1;
+        for (; cut < box.size() - 1; ++cut) {
+            acc += bins[box[cut - 1]].n;
+            if (acc * 2 >= total) break;
+        }
+        std::vector<int> upper(box.begin() + cut, box.end());
+        box.resize(cut);
+        boxes.push_back(std::move(upper));
+    }
+    return boxes;
+}
+} // namespace quant
+
+// Reduce an RGB image to at most `colors` (2–256) entries. Writes one
+// index per pixel to `indices` and returns the palette as packed RGB.
+// `dither` adds a 4×4 ordered (Bayer) pattern, which hides banding in
+// gradients at some cost in compressed size. An empty image gets an
+// empty palette.
+std::vector<unsigned char> quantize_rgb(const unsigned char* rgb, int w, int h, int colors,
+                                        bool dither, std::vector<unsigned char>& indices) {
+    using namespace quant;
+    static const int bayer[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 },
+                                     { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+    colors = std::clamp(colors, 2, 256);
+    size_t pixels = static_cast<size_t>(w) * h;
+    if (w <= 0 || h <= 0) {
+        indices.clear();
+        return {};
+    }
+
+    // Histogram of a subsample (about 128K pixels is plenty for a palette)
+    std::vector<Bin> bins(BINS);
+    size_t step = pixels / (1u << 17) + 1;
+    for (size_t p = 0; p < pixels; p += step) {
+        const unsigned char* px = rgb + p * 3;
+        Bin& bin = bins[bin_of(px[0], px[1], px[2])];
+        ++bin.n;
+        bin.r += px[0]; bin.g += px[1]; bin.b += px[2];
+    }
+    std::vector<int> used;
+    for (int i = 0; i < BINS; ++i) {
+        Bin& bin = bins[i];
+        if (!bin.n) continue;
+        bin.r /= bin.n; bin.g /= bin.n; bin.b /= bin.n;
+        used.push_back(i);
+    }
+
+    Nearest pal;
+    for (const std::vector<int>& box : median_cut(bins, used, colors)) {
+        double n = 0, r = 0, g = 0, b = 0;
+        for (int i : box) {
+            n += bins[i].n;
+            r += bins[i].r * bins[i].n; g += bins[i].g * bins[i].n; b += bins[i].b * bins[i].n;
+        }
+        pal.r[pal.size] = static_cast<float>(r / n);
+        pal.g[pal.size] = static_cast<float>(g / n);
+        pal.b[pal.size] = static_cast<float>(b / n);
+        ++pal.size;
+    }
+
+    // k‑means refinement, weighting each bin by its pixel count
+    for (int iter = 0; iter < 3; ++iter) {
+        double n[256] = {}, r[256] = {}, g[256] = {}, b[256] = {};
+        for (int i : used) {
+            const Bin& bin = bins[i];
+            int k = pal(bin.r, bin.g, bin.b);
+            n[k] += bin.n;
+            r[k] += bin.r * bin.n; g[k] += bin.g * bin.n; b[k] += bin.b * bin.n;
+        }
+        for (int k = 0; k < pal.size; ++k) {
+            if (!n[k]) continue;
+            pal.r[k] = static_cast<float>(r[k] / n[k]);
+            pal.g[k] = static_cast<float>(g[k] / n[k]);
+            pal.b[k] = static_cast<float>(b[k] / n[k]);
+        }
+    }
+
+    // Map pixels through the inverse colour map (nearest entry to each
+    // bin's centre, computed on first use)
+    std::vector<int16_t> inverse(BINS, -1);
+    indices.resize(pixels);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            size_t p = static_cast<size_t>(y) * w + x;
+            int r = rgb[p * 3], g = rgb[p * 3 + 1], b = rgb[p * 3 + 2];
+            if (dither) {
+                int d = bayer[y & 3][x & 3] * 2 - 15;
+                r = std::clamp(r + d, 0, 255);
+                g = std::clamp(g + d, 0, 255);
+                b = std::clamp(b + d, 0, 255);
+            }
+            int i = bin_of(r, g, b);
+            if (inverse[i] < 0)
+                inverse[i] = static_cast<int16_t>(pal((r & ~7) + 4, (g & ~7) + 4, (b & ~7) + 4));
+            indices[p] = static_cast<unsigned char>(inverse[i]);
+        }
+    }
+
+    std::vector<unsigned char> palette(static_cast<size_t>(pal.size) * 3);
+    for (int k = 0; k < pal.size; ++k) {
+        palette[k * 3]     = static_cast<unsigned char>(std::lround(pal.r[k]));
+        palette[k * 3 + 1] = static_cast<unsigned char>(std::lround(pal.g[k]));
+        palette[k * 3 + 2] = static_cast<unsigned char>(std::lround(pal.b[k]));
+    }
+    return palette;
+}
+
+// ------------------------------------------------------------------
+// QOI codec for cached RGB pages. Scans shrink to a third or so of raw
+// size and decode far faster than the JPEGs they came from, which is
+// what the shared and on‑disk page caches want. Files are standard QOI;
+// grayscale pages are stored as r = g = b (which QOI codes in one or two
+// bytes per change) and come back as one channel.
+// ------------------------------------------------------------------
+namespace qoi {
+enum : unsigned char { OP_INDEX = 0x00, OP_DIFF = 0x40, OP_LUMA = 0x80,
+                       OP_RUN = 0xc0, OP_RGB = 0xfe, MASK = 0xc0 };
+static const unsigned char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+static constexpr size_t HEADER = 14;
+
+struct Px { unsigned char r, g, b, a; };
+inline bool operator==(Px x, Px y) {
+    return x.r == y.r && x.g == y.g && x.b == y.b && x.a == y.a;
+}
+inline int hash(Px p) { return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) % 64; }
+}
+
+std::vector<unsigned char> encode_qoi(const unsigned char* pixels, int w, int h,
+                                      int channels = 3) {
+    size_t n = static_cast<size_t>(w) * h;
+    std::vector<unsigned char> out;
+    out.reserve(qoi::HEADER + n * 4 / 3 + sizeof(qoi::padding));
+    out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+    png_put_u32(out, static_cast<uint32_t>(w));   // QOI is big‑endian too
+    png_put_u32(out, static_cast<uint32_t>(h));
+    out.push_back(3);   // RGB
+    out.push_back(0);   // sRGB
+
+    qoi::Px index[64] = {};
+    qoi::Px prev = { 0, 0, 0, 255 };
+    int run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned char* s = pixels + i * channels;
+        qoi::Px px = channels == 1 ? qoi::Px{ s[0], s[0], s[0], 255 }
+                                   : qoi::Px{ s[0], s[1], s[2], 255 };
+        if (px == prev) {
+            if (++run == 62 || i + 1 == n) {
+                out.push_back(qoi::OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run) {
+            out.push_back(qoi::OP_RUN | (run - 1));
+            run = 0;
+        }
+        int slot = qoi::hash(px);
+        if (index[slot] == px) {
+            out.push_back(qoi::OP_INDEX | slot);
+        } else {
+            index[slot] = px;
+            signed char vr = px.r - prev.r, vg = px.g - prev.g, vb = px.b - prev.b;
+            signed char vg_r = vr - vg, vg_b = vb - vg;
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                out.push_back(qoi::OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+            } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                out.push_back(qoi::OP_LUMA | (vg + 32));
+                out.push_back((vg_r + 8) << 4 | (vg_b + 8));
+            } else {
+                out.insert(out.end(), { qoi::OP_RGB, px.r, px.g, px.b });
+            }
+        }
+        prev = px;
+    }
+    out.insert(out.end(), qoi::padding, qoi::padding + sizeof(qoi::padding));
+    return out;
+}
+
+// Decode an RGB QOI image of the expected size into `channels` (3, or 1
+// for a grayscale page); false if it is not one
+bool decode_qoi(const unsigned char* data, size_t size, int w, int h,
+                std::vector<unsigned char>& pixels, int channels = 3) {
+    if (size < qoi::HEADER + sizeof(qoi::padding) || memcmp(data, "qoif", 4) != 0)
+        return false;
+    auto be32 = [&](size_t at) {
+        return static_cast<uint32_t>(data[at]) << 24 | data[at + 1] << 16 |
+               data[at + 2] << 8 | data[at + 3];
+    };
+    if (be32(4) != static_cast<uint32_t>(w) || be32(8) != static_cast<uint32_t>(h))
+        return false;
+
+    size_t n = static_cast<size_t>(w) * h;
+    pixels.resize(n * channels);
+    unsigned char* dst = pixels.data();
+    qoi::Px index[64] = {};
+    qoi::Px px = { 0, 0, 0, 255 };
+    size_t p = qoi::HEADER, end = size - sizeof(qoi::padding);
+    int run = 0;
+    for (size_t i = 0; i < n; ++i, dst += channels) {
+        if (run > 0) {
+            --run;
+        } else if (p < end) {
+            unsigned char b1 = data[p++];
+            if (b1 == qoi::OP_RGB) {
+                if (p + 3 > end) return false;
+                px.r = data[p];
+                px.g = data[p + 1];
+                px.b = data[p + 2];
+                p += 3;
+            } else if (b1 == 0xff) {
+                return false;   // RGBA chunk – never written for pages
+            } else if ((b1 & qoi::MASK) == qoi::OP_INDEX) {
+                px = index[b1];
+            } else if ((b1 & qoi::MASK) == qoi::OP_DIFF) {
+                px.r += ((b1 >> 4) & 3) - 2;
+                px.g += ((b1 >> 2) & 3) - 2;
+                px.b += (b1 & 3) - 2;
+            } else if ((b1 & qoi::MASK) == qoi::OP_LUMA) {
+                if (p >= end) return false;
+                unsigned char b2 = data[p++];
+                int vg = (b1 & 0x3f) - 32;
+                px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                px.g += vg;
+                px.b += vg - 8 + (b2 & 0x0f);
+            } else {
+                run = b1 & 0x3f;
+            }
+            index[qoi::hash(px)] = px;
+        } else {
+            return false;   // ran out of data
+        }
+        dst[0] = px.r;
+        if (channels == 1) continue;
+        dst[1] = px.g;
+        dst[2] = px.b;
+    }
+    return true;
+}
+
 // ------------------------------------------------------------------
 // Natural sort comparator (used for file listings)
 // ------------------------------------------------------------------
@@ -135,7 +924,20 @@ bool natural_sort_compare(const std::string& a, const std::string& b) {
 // ------------------------------------------------------------------
 // Rendering mode enum
 // ------------------------------------------------------------------
-enum class RenderMode { KITTY, TIMG, ASCII };
+enum class RenderMode { KITTY, ITERM2, TIMG, ASCII };
+
+// ------------------------------------------------------------------
+// Transmission quality policy (quality = auto|full|low)
+// ------------------------------------------------------------------
+enum class Quality { AUTO, FULL, LOW };
+
+// How pages are scaled: straight on the sRGB bytes (fast) or in linear
+// light, which keeps thin lines and screentones at their real weight
+enum class ResizeFilter { LINEAR, SRGB };
+
+// Rendering options that change a page's pixels; the page caches keep
+// renditions made with different ones apart
+enum RenderStyle : int { STYLE_SRGB = 1, STYLE_DESCREEN = 2 };
 
 // ------------------------------------------------------------------
 // Configuration holder (includes key‑map)
@@ -145,6 +947,21 @@ struct Config {
     bool double_page = false;
     bool show_help   = false;
     RenderMode render_mode = RenderMode::KITTY;
+    bool render_mode_auto  = true;   // pick the backend from the terminal probe
+    size_t kitty_memory_mb = 192;    // terminal‑side image budget (Kitty)
+    bool use_daemon = false;         // share decodes through tcreaderd
+    size_t daemon_cache_mb = 1024;   // decoded pages the daemon keeps
+    bool shared_cache = false;       // share scaled pages between readers
+    size_t shared_cache_mb = 256;
+    bool render_cache = false;       // keep rendered pages on disk
+    size_t render_cache_mb = 512;
+    bool telemetry = false;          // log per‑page timings for `tcreader stats`
+    Quality quality = Quality::AUTO;
+    ResizeFilter resize_filter = ResizeFilter::LINEAR;
+    bool descreen = false;           // soften halftone dots before scaling
+    int palette_colors = 0;          // indexed transmission (0 = off)
+    bool palette_auto = false;       // … only when the link is slow
+    bool palette_dither = false;
     std::vector<std::string> library_paths;
 
     Config() {
@@ -177,10 +994,16 @@ struct Config {
         keymap["pan_right"]     = "L";               // Shift‑L  (or Shift‑→)
 
         // Miscellaneous
+        keymap["search"]        = "/";               // fuzzy search the library
         keymap["toggle_spread"] = "s";
         keymap["double_page"]   = "d";   // optional extra shortcut
     }
 
+    int render_style() const {
+        return (resize_filter == ResizeFilter::SRGB ? STYLE_SRGB : 0) |
+               (descreen ? STYLE_DESCREEN : 0);
+    }
+
     // ------------------------------------------------------------------
     // Load configuration from a simple INI‑like file
     // ------------------------------------------------------------------
@@ -208,9 +1031,41 @@ struct Config {
                 } else if (key == "show_help") {
                     show_help = (val == "true" || val == "1");
                 } else if (key == "render_mode") {
+                    render_mode_auto = (val == "auto");
                     if (val == "timg") render_mode = RenderMode::TIMG;
+                    else if (val == "iterm2") render_mode = RenderMode::ITERM2;
                     else if (val == "ascii") render_mode = RenderMode::ASCII;
                     else render_mode = RenderMode::KITTY;
+                } else if (key == "kitty_memory_mb") {
+                    kitty_memory_mb = std::strtoul(val.c_str(), nullptr, 10);
+                } else if (key == "daemon") {
+                    use_daemon = (val == "true" || val == "1");
+                } else if (key == "daemon_cache_mb") {
+                    daemon_cache_mb = std::strtoul(val.c_str(), nullptr, 10);
+                } else if (key == "shared_cache") {
+                    shared_cache = (val == "true" || val == "1");
+                } else if (key == "shared_cache_mb") {
+                    shared_cache_mb = std::strtoul(val.c_str(), nullptr, 10);
+                } else if (key == "render_cache") {
+                    render_cache = (val == "true" || val == "1");
+                } else if (key == "render_cache_mb") {
+                    render_cache_mb = std::strtoul(val.c_str(), nullptr, 10);
+                } else if (key == "telemetry") {
+                    telemetry = (val == "true" || val == "1");
+                } else if (key == "quality") {
+                    if (val == "full") quality = Quality::FULL;
+                    else if (val == "low") quality = Quality::LOW;
+                    else quality = Quality::AUTO;
+                } else if (key == "resize") {
+                    resize_filter = val == "srgb" ? ResizeFilter::SRGB : ResizeFilter::LINEAR;
+                } else if (key == "descreen") {
+                    descreen = (val == "true" || val == "1");
+                } else if (key == "palette") {
+                    palette_auto = (val == "auto");
+                    palette_colors = palette_auto ? 256 : std::atoi(val.c_str());
+                    if (palette_colors) palette_colors = std::clamp(palette_colors, 2, 256);
+                } else if (key == "palette_dither") {
+                    palette_dither = (val == "true" || val == "1");
                 } else if (key == "library") {
                     library_paths.push_back(val);
                 } else {
@@ -221,6 +1076,182 @@ struct Config {
     }
 };
 
+// ------------------------------------------------------------------
+// Per‑user cache directory ($XDG_CACHE_HOME/tcreader or ~/.cache/tcreader)
+// ------------------------------------------------------------------
+std::string cache_dir() {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    std::string dir;
+    if (xdg && *xdg) dir = std::string(xdg) + "/tcreader";
+    else if (home && *home) dir = std::string(home) + "/.cache/tcreader";
+    else return "";
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    return ec ? "" : dir;
+}
+
+// ------------------------------------------------------------------
+// Terminal capabilities (probed once, cached per $TERM/$TERM_PROGRAM,
+// $LC_TERMINAL and whether $KITTY_WINDOW_ID is set – ssh and tmux pass
+// those through when TERM_PROGRAM is lost).
+// The cell size depends on the font and is queried again at every start.
+// ------------------------------------------------------------------
+struct TermCaps {
+    bool kitty  = false;     // answered the Kitty graphics query
+    bool sixel  = false;     // DA1 lists attribute 4
+    bool iterm2 = false;     // OSC 1337 capable (from the environment)
+    int cell_w = 0, cell_h = 0;   // exact cell size in pixels, 0 = unknown (not cached)
+};
+
+static TermCaps term_caps;
+
+static std::string term_caps_key() {
+    const char* term = getenv("TERM");
+    const char* prog = getenv("TERM_PROGRAM");
+    const char* lc = getenv("LC_TERMINAL");
+    return std::string(term ? term : "") + "|" + (prog ? prog : "") + "|" + (lc ? lc : "") +
+           (getenv("KITTY_WINDOW_ID") ? "|kitty" : "|");
+}
+
+static std::string term_caps_path() {
+    std::string dir = cache_dir();
+    return dir.empty() ? "" : dir + "/termcaps";
+}
+
+bool load_term_caps(TermCaps& caps) {
+    std::ifstream file(term_caps_path());
+    if (!file.is_open()) return false;
+
+    std::string key = term_caps_key(), line;
+    while (std::getline(file, line)) {
+        auto tab = line.find('\t');
+        if (tab == std::string::npos || line.substr(0, tab) != key) continue;
+
+        std::istringstream in(line.substr(tab + 1));
+        in >> caps.kitty >> caps.sixel >> caps.iterm2;
+        return !in.fail();
+    }
+    return false;
+}
+
+void save_term_caps(const TermCaps& caps) {
+    std::string path = term_caps_path();
+    if (path.empty()) return;
+
+    // Keep the entries of other terminals, replace ours
+    std::vector<std::string> lines;
+    std::string key = term_caps_key(), line;
+    {
+        std::ifstream in(path);
+        while (std::getline(in, line))
+            if (line.substr(0, line.find('\t')) != key) lines.push_back(line);
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) return;
+    for (const auto& l : lines) file << l << "\n";
+    file << key << "\t" << caps.kitty << " " << caps.sixel << " " << caps.iterm2 << "\n";
+}
+
+// Send the Kitty graphics query (unless only the cell size is wanted),
+// CSI 16t / 14t and DA1, then collect the replies. Every terminal answers
+// DA1, and answers in order, so its reply marks the end of the probe and
+// the generous timeout only costs time on a terminal that never answers.
+// A shorter one would leave the replies of a slow (e.g. SSH) link to be
+// read as keystrokes. Needs the tty in raw mode. Returns false when
+// nothing answered within the timeout (e.g. not a terminal).
+bool probe_terminal(TermCaps& caps, bool graphics = true, int timeout_ms = 1000) {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) return false;
+
+    std::string query = graphics ? "\033_Gi=31,s=1,v=1,a=q,t=d,f=24;AAAA\033\\" : "";
+    query += "\033[16t"     // cell size in px
+             "\033[14t"     // window size in px
+             "\033[c";      // DA1
+    if (write(STDOUT_FILENO, query.data(), query.size()) < 0) return false;
+
+    std::string reply;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeout_ms);
+    bool got_da1 = false;
+    while (!got_da1) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) break;
+
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, static_cast<int>(left)) <= 0) break;
+
+        char buf[256];
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) break;
+        reply.append(buf, n);
+
+        auto da1 = reply.find("\033[?");
+        got_da1 = da1 != std::string::npos &&
+                  reply.find('c', da1) != std::string::npos;
+    }
+    if (!got_da1) {
+        tcflush(STDIN_FILENO, TCIFLUSH);    // drop a partial reply
+        return false;
+    }
+
+    auto da1 = reply.find("\033[?");
+    if (graphics) {
+        caps.kitty = reply.find("\033_Gi=31;OK") != std::string::npos;
+        std::stringstream attrs(reply.substr(da1 + 3, reply.find('c', da1) - da1 - 3));
+        std::string attr;
+        while (std::getline(attrs, attr, ';'))
+            if (attr == "4") caps.sixel = true;
+    }
+
+    int a = 0, b = 0;
+    auto cell = reply.find("\033[6;");
+    auto win  = reply.find("\033[4;");
+    if (cell != std::string::npos &&
+        sscanf(reply.c_str() + cell, "\033[6;%d;%dt", &a, &b) == 2 && a > 0 && b > 0) {
+        caps.cell_h = a;
+        caps.cell_w = b;
+    } else if (win != std::string::npos &&
+               sscanf(reply.c_str() + win, "\033[4;%d;%dt", &a, &b) == 2) {
+        struct winsize w{};
+        ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+        if (w.ws_row > 0 && w.ws_col > 0 && a > 0 && b > 0) {
+            caps.cell_h = a / w.ws_row;
+            caps.cell_w = b / w.ws_col;
+        }
+    }
+
+    if (graphics) {
+        const char* prog = getenv("TERM_PROGRAM");
+        const char* lc_term = getenv("LC_TERMINAL");
+        caps.iterm2 = (prog && (!strcmp(prog, "iTerm.app") || !strcmp(prog, "WezTerm"))) ||
+                      (lc_term && !strcmp(lc_term, "iTerm2"));
+    }
+    return true;
+}
+
+static bool program_in_path(const std::string& name) {
+    const char* path = getenv("PATH");
+    if (!path) return false;
+    std::stringstream dirs(path);
+    std::string dir;
+    while (std::getline(dirs, dir, ':'))
+        if (!dir.empty() && access((dir + "/" + name).c_str(), X_OK) == 0)
+            return true;
+    return false;
+}
+
+// Fastest backend first: Kitty (raw pixels, no re‑encode), iTerm2
+// (compressed passthrough), timg (handles sixel), then ASCII.
+RenderMode pick_render_mode(const TermCaps& caps) {
+    if (caps.kitty)  return RenderMode::KITTY;
+    if (caps.iterm2) return RenderMode::ITERM2;
+    if (program_in_path("timg")) return RenderMode::TIMG;
+    return RenderMode::ASCII;
+}
+
 // ------------------------------------------------------------------
 // Terminal size helper
 // ------------------------------------------------------------------
@@ -230,134 +1261,2630 @@ struct TermSize {
 };
 
 TermSize get_term_size() {
-    struct winsize w;
+    struct winsize w{};
     ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
 
+    // Prefer the kernel's pixel size, then the probed cell size, then a guess
+    int cell_w = term_caps.cell_w > 0 ? term_caps.cell_w : 10;
+    int cell_h = term_caps.cell_h > 0 ? term_caps.cell_h : 20;
+
     TermSize size;
-    size.rows = w.ws_row;
-    size.cols = w.ws_col;
-    size.pixel_width  = w.ws_xpixel > 0 ? w.ws_xpixel : w.ws_col * 10;
-    size.pixel_height = w.ws_ypixel > 0 ? w.ws_ypixel : w.ws_row * 20;
+    size.rows = std::max<int>(1, w.ws_row);
+    size.cols = std::max<int>(1, w.ws_col);
+    size.pixel_width  = w.ws_xpixel > 0 ? w.ws_xpixel : size.cols * cell_w;
+    size.pixel_height = w.ws_ypixel > 0 ? w.ws_ypixel : size.rows * cell_h;
     return size;
 }
 
 // ------------------------------------------------------------------
-// Archive handling (libarchive wrapper)
+// Output throughput estimate. Writes to a pty block once the kernel
+// buffer is full, so the time spent writing a large image approximates
+// how fast the terminal (or the SSH link in front of it) drains it.
 // ------------------------------------------------------------------
-struct PageEntry {
-    std::string name;
-    size_t index_in_archive;
+class ThroughputEstimator {
+private:
+    double bytes_per_sec = 0;     // 0 = no usable sample yet
+
+public:
+    void sample(size_t bytes, double seconds) {
+        // Small writes only fill the pty buffer and say nothing about the link
+        if (bytes < 256 * 1024 || seconds <= 0) return;
+        double rate = bytes / seconds;
+        bytes_per_sec = bytes_per_sec > 0 ? 0.7 * bytes_per_sec + 0.3 * rate : rate;
+    }
+
+    double seconds_for(size_t bytes) const {
+        return bytes_per_sec > 0 ? bytes / bytes_per_sec : 0;
+    }
+
+    double rate() const { return bytes_per_sec; }
 };
 
-class ArchiveReader {
+// ------------------------------------------------------------------
+// Non‑blocking output queue. Everything the comic view draws is queued as
+// whole escape sequences and written from the event loop as the terminal
+// drains it, so keys are still read during a slow transfer. abandon()
+// cuts obsolete image transfers at a chunk boundary.
+// ------------------------------------------------------------------
+class OutputWriter {
 private:
-    struct archive* archive_handle = nullptr;
-    std::string archive_path;
-    std::vector<PageEntry> entries;
-    int current_entry = -1;
+    struct Chunk {
+        std::string data;
+        bool droppable;         // part of an image – may be abandoned
+        uint32_t kitty_id;      // Kitty image this chunk belongs to (0 = none)
+        bool last;              // final chunk of that image (m=0)
+    };
+
+    int fd;
+    std::deque<Chunk> queue;
+    size_t head_written = 0;            // bytes of queue.front() already out
+    std::set<uint32_t> open_images;     // Kitty transfers started, not finished
+    bool timing = false;                // an image transfer is being timed
+    size_t busy_bytes = 0;
+    std::chrono::steady_clock::time_point busy_since;
+
+    void chunk_done(const Chunk& c) {
+        if (!c.kitty_id) return;
+        if (c.last) open_images.erase(c.kitty_id);
+        else open_images.insert(c.kitty_id);
+    }
+
+    void write_all(const std::string& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            off += n;
+        }
+    }
 
 public:
-    ~ArchiveReader() { close(); }
+    ThroughputEstimator throughput;
 
-    bool open(const std::string& path) {
-        close();
+    explicit OutputWriter(int out_fd) : fd(out_fd) {}
 
-        archive_path = path;
-        archive_handle = archive_read_new();
-        archive_read_support_format_all(archive_handle);
-        archive_read_support_filter_all(archive_handle);
+    bool pending() const { return !queue.empty(); }
 
-        if (archive_read_open_filename(archive_handle, path.c_str(), 10240) != ARCHIVE_OK) {
-            close();
-            return false;
+    void push(std::string data) {
+        if (!data.empty()) enqueue(Chunk{ std::move(data), false, 0, true });
+    }
+
+    // An image payload; kitty_id/last let abandon() close the transfer
+    void push_image(std::string data, uint32_t kitty_id = 0, bool last = true) {
+        enqueue(Chunk{ std::move(data), true, kitty_id, last });
+    }
+
+    void enqueue(Chunk c) { queue.push_back(std::move(c)); }
+
+    // Write whatever the terminal accepts right now. O_NONBLOCK is only set
+    // for the duration: stdin usually shares the same open tty.
+    void pump() {
+        if (queue.empty()) return;
+        std::cout.flush();
+        fflush(stdout);
+
+        int flags = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        while (!queue.empty()) {
+            Chunk& c = queue.front();
+            // The link is timed from the first image byte written, so the
+            // decode and scale behind a draw are not counted against it
+            if (!timing && c.droppable) {
+                timing = true;
+                busy_since = std::chrono::steady_clock::now();
+                busy_bytes = 0;
+            }
+            ssize_t n = ::write(fd, c.data.data() + head_written,
+                                c.data.size() - head_written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;              // EAGAIN – terminal is busy
+            head_written += n;
+            busy_bytes += n;
+            if (head_written == c.data.size()) {
+                chunk_done(c);
+                queue.pop_front();
+                head_written = 0;
+            }
+        }
+        fcntl(fd, F_SETFL, flags);
+
+        if (queue.empty() && timing) {
+            timing = false;
+            throughput.sample(busy_bytes, std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - busy_since).count());
+        }
+    }
+
+    // Write everything still queued, blocking
+    void drain() {
+        std::cout.flush();
+        fflush(stdout);
+        while (!queue.empty()) {
+            Chunk& c = queue.front();
+            write_all(c.data.substr(head_written));
+            chunk_done(c);
+            queue.pop_front();
+            head_written = 0;
+        }
+        timing = false;
+    }
+
+    // Drop queued image data. A chunk already half written is finished
+    // first; Kitty transfers cut midway get a final empty m=0 chunk and a
+    // delete. Transfers of the ids in `keep` carry on, and those closing
+    // sequences wait until a kept transfer in progress has finished, as
+    // Kitty's chunks must not be interleaved. Returns the ids of all Kitty
+    // images that will never complete.
+    std::vector<uint32_t> abandon(const std::vector<uint32_t>& keep = {}) {
+        auto kept = [&](uint32_t id) {
+            return id && std::find(keep.begin(), keep.end(), id) != keep.end();
+        };
+
+        if (!queue.empty() && head_written > 0) {
+            Chunk& c = queue.front();
+            write_all(c.data.substr(head_written));
+            chunk_done(c);
+            queue.pop_front();
+            head_written = 0;
+        }
+
+        std::set<uint32_t> cancelled;
+        std::deque<Chunk> remaining;
+        for (auto& c : queue) {
+            if (!c.droppable || kept(c.kitty_id)) remaining.push_back(std::move(c));
+            else if (c.kitty_id) cancelled.insert(c.kitty_id);
+        }
+        queue.swap(remaining);
+
+        std::string close;
+        size_t after = 0;      // queue position past every kept open transfer
+        for (auto it = open_images.begin(); it != open_images.end();) {
+            if (kept(*it)) {
+                for (size_t i = 0; i < queue.size(); ++i)
+                    if (queue[i].kitty_id == *it && queue[i].last) after = std::max(after, i + 1);
+                ++it;
+                continue;
+            }
+            close += strfmt("\033_Gm=0;\033\\\033_Ga=d,d=I,i=%u,q=2\033\\", *it);
+            cancelled.insert(*it);
+            it = open_images.erase(it);
+        }
+        if (after == 0) write_all(close);
+        else if (!close.empty()) queue.insert(queue.begin() + after, Chunk{ close, false, 0, true });
+
+        // Whatever survived (text, deletes, kept transfers) is sent in order
+        if (keep.empty()) drain();
+        return std::vector<uint32_t>(cancelled.begin(), cancelled.end());
+    }
+};
+
+// ------------------------------------------------------------------
+// Decoded page pixels (owned locally or mapped from shared memory)
+// ------------------------------------------------------------------
+struct DecodedPage {
+    int w = 0, h = 0, channels = 3;
+    std::shared_ptr<const unsigned char> pixels;   // deleter frees / unmaps
+
+    bool empty() const { return !pixels; }
+    size_t size() const { return static_cast<size_t>(w) * h * channels; }
+};
+
+// Decode with stb_image into a DecodedPage that frees itself. channels=0
+// keeps a grayscale source (1‑component JPEG, gray PNG) at one channel
+// and gives three for everything else.
+DecodedPage decode_image(const std::vector<unsigned char>& data, int channels = 3) {
+    DecodedPage page;
+    int ch;
+    if (channels == 0) {
+        int w, h;
+        channels = stbi_info_from_memory(data.data(), static_cast<int>(data.size()),
+                                         &w, &h, &ch) && ch == 1 ? 1 : 3;
+    }
+    unsigned char* pixels = stbi_load_from_memory(
+        data.data(), static_cast<int>(data.size()), &page.w, &page.h, &ch, channels);
+    if (!pixels) return {};
+    page.channels = channels;
+    page.pixels.reset(pixels, [](const unsigned char* p) {
+        stbi_image_free(const_cast<unsigned char*>(p));
+    });
+    return page;
+}
+
+// Scale tightly packed 1‑ or 3‑channel pixels. The sRGB path converts
+// to linear light and back around the filter; stb's SIMD kernels keep
+// that to roughly a quarter more time than the plain byte path.
+void resize_pixels(const unsigned char* src, int w, int h, unsigned char* dst,
+                   int new_w, int new_h, int channels, ResizeFilter filter) {
+    stbir_pixel_layout layout = channels == 1 ? STBIR_1CHANNEL : STBIR_RGB;
+    if (filter == ResizeFilter::SRGB)
+        stbir_resize_uint8_srgb(src, w, h, 0, dst, new_w, new_h, 0, layout);
+    else
+        stbir_resize_uint8_linear(src, w, h, 0, dst, new_w, new_h, 0, layout);
+}
+
+// Halftone suppression for scanned print. A printed page is about 6.6"
+// wide and screened at around 133 lpi, so the scan width gives the dot
+// period in pixels; a landscape image is taken to be a two-page spread.
+// A Gaussian of half that period removes the dots (and the moiré they
+// alias into when scaled) but keeps line work. Scans too coarse to
+// resolve the dots are returned as they are.
+DecodedPage descreen_page(const DecodedPage& page) {
+    int page_w = page.w > page.h ? page.w / 2 : page.w;
+    float sigma = page_w / 6.6f / 133.0f * 0.5f;
+    if (page.empty() || sigma < 0.6f) return page;
+
+    // Gaussian taps out to 2σ in 8‑bit fixed point, summing to exactly 256
+    int radius = std::min(8, static_cast<int>(std::ceil(sigma * 2)));
+    int taps = 2 * radius + 1;
+    std::vector<double> g(taps);
+    double total = 0;
+    for (int k = 0; k < taps; ++k) {
+        g[k] = std::exp(-(k - radius) * (k - radius) / (2.0 * sigma * sigma));
+        total += g[k];
+    }
+    std::vector<unsigned> weight(taps);
+    unsigned sum = 0;
+    for (int k = 0; k < taps; ++k) {
+        if (k == radius) continue;
+        weight[k] = static_cast<unsigned>(std::lround(g[k] / total * 256));
+        sum += weight[k];
+    }
+    weight[radius] = 256 - sum;
+
+    int w = page.w, h = page.h, ch = page.channels;
+    size_t stride = static_cast<size_t>(w) * ch;
+    std::shared_ptr<unsigned char> out(new unsigned char[page.size()],
+                                       std::default_delete<unsigned char[]>());
+    const unsigned char* src = page.pixels.get();
+    std::vector<uint16_t> acc(stride);
+    kern::TapFn accumulate_tap = kernels().tap.fn;
+
+    // Vertical pass, one output row at a time (edges repeat)
+    for (int y = 0; y < h; ++y) {
+        std::fill(acc.begin(), acc.end(), 128);
+        for (int k = 0; k < taps; ++k)
+            accumulate_tap(acc.data(), src + std::clamp(y + k - radius, 0, h - 1) * stride,
+                           stride, weight[k]);
+        unsigned char* dst = out.get() + y * stride;
+        for (size_t i = 0; i < stride; ++i) dst[i] = static_cast<unsigned char>(acc[i] >> 8);
+    }
+
+    // Horizontal pass in place, through a copy of the row padded at both ends
+    size_t pad = static_cast<size_t>(radius) * ch;
+    std::vector<unsigned char> padded(stride + 2 * pad);
+    for (int y = 0; y < h; ++y) {
+        unsigned char* row = out.get() + y * stride;
+        memcpy(&padded[pad], row, stride);
+        for (size_t i = 0; i < pad; ++i) {
+            padded[i] = row[i % ch];
+            padded[pad + stride + i] = row[stride - ch + i % ch];
+        }
+        std::fill(acc.begin(), acc.end(), 128);
+        for (int k = 0; k < taps; ++k)
+            accumulate_tap(acc.data(), &padded[static_cast<size_t>(k) * ch], stride, weight[k]);
+        for (size_t i = 0; i < stride; ++i) row[i] = static_cast<unsigned char>(acc[i] >> 8);
+    }
+
+    DecodedPage result = page;
+    result.pixels = out;
+    return result;
+}
+
+// ------------------------------------------------------------------
+// Reading‑session daemon protocol. tcreaderd owns the archives, decodes
+// pages once and hands every client the same memfd (passed with
+// SCM_RIGHTS over a Unix socket), so N terminals share one decode and
+// one copy of the pixels.
+// ------------------------------------------------------------------
+enum : uint32_t { DAEMON_OPEN = 1, DAEMON_RAW = 2, DAEMON_DECODE = 3 };
+
+struct DaemonRequest {
+    uint32_t op;
+    uint32_t page;
+    uint32_t path_len;          // followed by the archive path
+};
+
+struct DaemonReply {
+    int32_t status;             // 0 = ok
+    uint32_t w, h, channels;    // DAEMON_DECODE only
+    uint64_t size;              // payload bytes (inline for OPEN, in the fd otherwise)
+};
+
+std::string daemon_socket_path() {
+    const char* run = getenv("XDG_RUNTIME_DIR");
+    if (run && *run) return std::string(run) + "/tcreaderd.sock";
+    return "/tmp/tcreaderd-" + std::to_string(getuid()) + ".sock";
+}
+
+// The /tmp fallback name is predictable, so both ends check that the
+// other side of the socket runs as the same user
+static bool peer_is_us(int sock) {
+    struct ucred cred{};
+    socklen_t len = sizeof(cred);
+    return getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == getuid();
+}
+
+static bool write_full(int fd, const void* buf, size_t len) {
+    const char* p = static_cast<const char*>(buf);
+    while (len) {
+        ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool read_full(int fd, void* buf, size_t len) {
+    char* p = static_cast<char*>(buf);
+    while (len) {
+        ssize_t n = ::read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// write_full for files and memfds (send() only works on sockets)
+static bool write_full_fd(int fd, const void* buf, size_t len) {
+    const char* p = static_cast<const char*>(buf);
+    while (len) {
+        ssize_t n = ::write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Send `len` bytes with an optional file descriptor attached
+static bool send_with_fd(int sock, const void* buf, size_t len, int fd) {
+    struct iovec iov = { const_cast<void*>(buf), len };
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        memset(ctrl, 0, sizeof(ctrl));
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+    ssize_t n;
+    do n = sendmsg(sock, &msg, MSG_NOSIGNAL); while (n < 0 && errno == EINTR);
+    if (n < 0) return false;
+    return static_cast<size_t>(n) == len ||
+           write_full(sock, static_cast<const char*>(buf) + n, len - n);
+}
+
+static bool recv_with_fd(int sock, void* buf, size_t len, int* fd) {
+    *fd = -1;
+    struct iovec iov = { buf, len };
+    struct msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))];
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    ssize_t n;
+    do n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC); while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+            memcpy(fd, CMSG_DATA(cm), sizeof(int));
+    return static_cast<size_t>(n) == len ||
+           read_full(sock, static_cast<char*>(buf) + n, len - n);
+}
+
+// Map a received memfd read‑only; the DecodedPage unmaps it when released
+static std::shared_ptr<const unsigned char> map_shared(int fd, size_t size) {
+    // Touching pages past the end of a short file would raise SIGBUS
+    struct stat st;
+    if (size == 0 || fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < size) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return nullptr;
+    return std::shared_ptr<const unsigned char>(
+        static_cast<const unsigned char*>(mem),
+        [size](const unsigned char* p) { munmap(const_cast<unsigned char*>(p), size); });
+}
+
+// ------------------------------------------------------------------
+// Front‑end side of the daemon connection
+// ------------------------------------------------------------------
+class DaemonClient {
+private:
+    int sock = -1;
+    static constexpr uint64_t max_list_bytes = 16 << 20;   // page names of one archive
+    static constexpr uint32_t max_side = 1 << 16;          // pixels per page side
+
+    bool try_connect() {
+        sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (sock < 0) return false;
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::string path = daemon_socket_path();
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (::connect(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 &&
+            peer_is_us(sock))
+            return true;
+        ::close(sock);
+        sock = -1;
+        return false;
+    }
+
+    // Start `tcreader --daemon` detached from our session
+    static void spawn() {
+        pid_t pid = fork();
+        if (pid != 0) {
+            // Reap the intermediate child, which exits right away
+            int status;
+            while (pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+            return;
+        }
+        setsid();
+        if (fork() != 0) _exit(0);     // orphan the daemon so it is reaped by init
+        if (chdir("/") != 0) _exit(127);   // don't pin (or resolve paths in) our cwd
+        int null = ::open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        char self[4096];
+        ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+        if (n > 0) {
+            self[n] = '\0';
+            execl(self, "tcreaderd", "--daemon", static_cast<char*>(nullptr));
+        }
+        _exit(127);
+    }
+
+    bool request(uint32_t op, const std::string& path, uint32_t page,
+                 DaemonReply& rep, int& fd) {
+        fd = -1;
+        if (sock < 0) return false;
+        // The daemon has its own working directory: send absolute paths
+        std::error_code ec;
+        std::string abs = fs::absolute(path, ec).lexically_normal().string();
+        if (ec) return false;
+        DaemonRequest req{ op, page, static_cast<uint32_t>(abs.size()) };
+        if (!write_full(sock, &req, sizeof(req)) ||
+            !write_full(sock, abs.data(), abs.size()) ||
+            !recv_with_fd(sock, &rep, sizeof(rep), &fd)) {
+            disconnect();
+            return false;
+        }
+        if (rep.status != 0 && fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        return rep.status == 0;
+    }
+
+public:
+    ~DaemonClient() { disconnect(); }
+
+    bool connected() const { return sock >= 0; }
+
+    bool connect(bool spawn_if_missing) {
+        if (try_connect()) return true;
+        if (!spawn_if_missing) return false;
+        spawn();
+        for (int i = 0; i < 50; ++i) {          // up to ~500 ms
+            usleep(10000);
+            if (try_connect()) return true;
+        }
+        return false;
+    }
+
+    void disconnect() {
+        if (sock >= 0) ::close(sock);
+        sock = -1;
+    }
+
+    bool open(const std::string& path, std::vector<std::string>& names) {
+        DaemonReply rep;
+        int fd;
+        if (!request(DAEMON_OPEN, path, 0, rep, fd)) return false;
+        if (rep.size > max_list_bytes) {
+            disconnect();
+            return false;
+        }
+        std::string list(rep.size, '\0');
+        if (!read_full(sock, &list[0], list.size())) {
+            disconnect();
+            return false;
+        }
+        names.clear();
+        std::istringstream in(list);
+        std::string name;
+        while (std::getline(in, name)) names.push_back(name);
+        return !names.empty();
+    }
+
+    std::vector<unsigned char> raw(const std::string& path, uint32_t page) {
+        DaemonReply rep;
+        int fd;
+        if (!request(DAEMON_RAW, path, page, rep, fd) || fd < 0) return {};
+        auto mem = map_shared(fd, rep.size);
+        if (!mem) return {};
+        return std::vector<unsigned char>(mem.get(), mem.get() + rep.size);
+    }
+
+    DecodedPage decode(const std::string& path, uint32_t page) {
+        DaemonReply rep;
+        int fd;
+        if (!request(DAEMON_DECODE, path, page, rep, fd) || fd < 0) return {};
+        if ((rep.channels != 1 && rep.channels != 3) || rep.w == 0 || rep.h == 0 ||
+            rep.w > max_side || rep.h > max_side ||
+            static_cast<uint64_t>(rep.w) * rep.h * rep.channels > rep.size) {
+            ::close(fd);
+            return {};
+        }
+        DecodedPage out;
+        out.w = rep.w;
+        out.h = rep.h;
+        out.channels = rep.channels;
+        out.pixels = map_shared(fd, rep.size);
+        return out;
+    }
+};
+
+// ------------------------------------------------------------------
+// ComicInfo.xml (the ComicRack metadata file many CBZs carry). A small
+// pull parser is enough: no DTDs, no namespaces, just tags, attributes,
+// text and the five predefined entities.
+// ------------------------------------------------------------------
+class XmlReader {
+private:
+    const std::string& src;
+    size_t pos = 0;
+
+    static std::string unescape(const std::string& s) {
+        static const std::pair<const char*, char> entities[] = {
+            { "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' },
+            { "&quot;", '"' }, { "&apos;", '\'' } };
+        std::string out;
+        for (size_t i = 0; i < s.size(); ++i) {
+            bool replaced = false;
+            if (s[i] == '&') {
+                for (const auto& [ent, ch] : entities) {
+                    if (s.compare(i, strlen(ent), ent) == 0) {
+                        out += ch;
+                        i += strlen(ent) - 1;
+                        replaced = true;
+                        break;
+                    }
+                }
+            }
+            if (!replaced) out += s[i];
+        }
+        return out;
+    }
+
+    bool skip_past(const char* marker) {
+        size_t end = src.find(marker, pos);
+        if (end == std::string::npos) return false;
+        pos = end + strlen(marker);
+        return true;
+    }
+
+public:
+    enum Kind { START, END, TEXT };
+    Kind kind = TEXT;
+    std::string name, text;
+    std::map<std::string, std::string> attrs;
+    bool self_closing = false;
+
+    explicit XmlReader(const std::string& xml) : src(xml) {}
+
+    // Advance to the next tag or text run; false at the end (or on junk)
+    bool next() {
+        while (pos < src.size()) {
+            if (src[pos] != '<') {
+                size_t end = src.find('<', pos);
+                if (end == std::string::npos) end = src.size();
+                text = unescape(src.substr(pos, end - pos));
+                pos = end;
+                kind = TEXT;
+                return true;
+            }
+            if (src.compare(pos, 4, "<!--") == 0) {
+                if (!skip_past("-->")) return false;
+                continue;
+            }
+            if (src.compare(pos, 9, "<![CDATA[") == 0) {
+                size_t start = pos + 9;
+                if (!skip_past("]]>")) return false;
+                text = src.substr(start, pos - 3 - start);
+                kind = TEXT;
+                return true;
+            }
+            if (src.compare(pos, 2, "<?") == 0 || src.compare(pos, 2, "<!") == 0) {
+                if (!skip_past(">")) return false;
+                continue;
+            }
+
+            size_t end = src.find('>', pos);
+            if (end == std::string::npos) return false;
+            std::string tag = src.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+            attrs.clear();
+            self_closing = !tag.empty() && tag.back() == '/';
+            if (self_closing) tag.pop_back();
+            if (!tag.empty() && tag[0] == '/') {
+                kind = END;
+                name = tag.substr(1);
+                name.erase(name.find_last_not_of(" \t\r\n") + 1);
+                return true;
+            }
+
+            kind = START;
+            size_t i = tag.find_first_of(" \t\r\n");
+            name = tag.substr(0, i);
+            while (i != std::string::npos && i < tag.size()) {
+                size_t key_start = tag.find_first_not_of(" \t\r\n", i);
+                if (key_start == std::string::npos) break;
+                size_t eq = tag.find('=', key_start);
+                if (eq == std::string::npos || eq + 1 >= tag.size()) break;
+                std::string key = tag.substr(key_start, eq - key_start);
+                key.erase(key.find_last_not_of(" \t\r\n") + 1);
+                size_t q = tag.find_first_of("\"'", eq);
+                if (q == std::string::npos) break;
+                size_t q_end = tag.find(tag[q], q + 1);
+                if (q_end == std::string::npos) break;
+                attrs[key] = unescape(tag.substr(q + 1, q_end - q - 1));
+                i = q_end + 1;
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+struct ComicInfo {
+    std::string series, number, title;
+    int page_count = 0;
+    bool has_pages = false;          // a <Pages> list was present
+    std::set<int> double_pages;      // page indices marked DoublePage
+    std::set<int> covers;            // Type="FrontCover"
+
+    bool empty() const { return series.empty() && title.empty() && !has_pages; }
+};
+
+ComicInfo parse_comic_info(const std::string& xml) {
+    ComicInfo info;
+    XmlReader xr(xml);
+    std::string field;   // the ComicInfo child whose text we are in
+    int depth = 0;
+    while (xr.next()) {
+        if (xr.kind == XmlReader::START) {
+            if (depth == 1) field = xr.name;
+            if (xr.name == "Pages") info.has_pages = true;
+            if (xr.name == "Page" && xr.attrs.count("Image")) {
+                int image = std::atoi(xr.attrs["Image"].c_str());
+                std::string dbl = xr.attrs["DoublePage"];
+                std::transform(dbl.begin(), dbl.end(), dbl.begin(), ::tolower);
+                if (dbl == "true" || dbl == "1") info.double_pages.insert(image);
+                if (xr.attrs["Type"] == "FrontCover") info.covers.insert(image);
+            }
+            if (!xr.self_closing) ++depth;
+        } else if (xr.kind == XmlReader::END) {
+            --depth;
+            field.clear();
+        } else if (depth == 2) {
+            if (field == "Series") info.series = xr.text;
+            else if (field == "Number") info.number = xr.text;
+            else if (field == "Title") info.title = xr.text;
+            else if (field == "PageCount") info.page_count = std::atoi(xr.text.c_str());
+        }
+    }
+    return info;
+}
+
+// ------------------------------------------------------------------
+// Archive handling (libarchive wrapper)
+// ------------------------------------------------------------------
+struct PageEntry {
+    std::string name;
+    size_t index_in_archive;
+};
+
+// What the page index cache keeps per archive (see PageIndexCache)
+struct PageIndex {
+    std::vector<PageEntry> pages;
+    std::vector<std::pair<int, int>> dims;   // w, h per page, 0 if unknown
+    ComicInfo info;
+};
+
+class ArchiveReader {
+private:
+    struct archive* archive_handle = nullptr;
+    std::string archive_path;
+    std::vector<PageEntry> entries;
+    ComicInfo info;                     // from ComicInfo.xml, if present
+    int current_entry = -1;
+    DaemonClient* remote = nullptr;     // set when a tcreaderd is in use
+    bool served_remotely = false;       // this archive is open in the daemon
+    const std::atomic<bool>* cancel = nullptr;   // stops header walks early
+
+    bool cancelled() const { return cancel && cancel->load(std::memory_order_relaxed); }
+
+public:
+    ~ArchiveReader() { close(); }
+
+    void use_daemon(DaemonClient* client) { remote = client; }
+
+    // Checked between entries, so a background open of a large solid
+    // archive can be abandoned promptly
+    void set_cancel(const std::atomic<bool>* flag) { cancel = flag; }
+    bool is_remote() const { return served_remotely; }
+
+    // Open through the daemon when one is connected (it already holds the
+    // index if another client has the archive open), else locally
+    bool open(const std::string& path) {
+        close();
+        if (remote && remote->connected()) {
+            std::vector<std::string> names;
+            if (remote->open(path, names)) {
+                archive_path = path;
+                for (size_t i = 0; i < names.size(); ++i)
+                    entries.push_back(PageEntry{ names[i], i });
+                served_remotely = true;
+                return true;
+            }
+        }
+        return open_local(path);
+    }
+
+    bool open_local(const std::string& path) {
+        close();
+
+        archive_path = path;
+        archive_handle = archive_read_new();
+        archive_read_support_format_all(archive_handle);
+        archive_read_support_filter_all(archive_handle);
+
+        if (archive_read_open_filename(archive_handle, path.c_str(), 10240) != ARCHIVE_OK) {
+            close();
+            return false;
+        }
+
+        // Index image entries; ComicInfo.xml is read in the same walk
+        entries.clear();
+        struct archive_entry* entry;
+        size_t idx = 0;
+
+        while (!cancelled() && archive_read_next_header(archive_handle, &entry) == ARCHIVE_OK) {
+            std::string name = archive_entry_pathname(entry);
+            std::string ext = fs::path(name).extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            std::string base = fs::path(name).filename().string();
+            std::transform(base.begin(), base.end(), base.begin(), ::tolower);
+
+            if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" ||
+                ext == ".gif" || ext == ".webp" || ext == ".bmp") {
+                PageEntry pg{ name, idx };
+                entries.push_back(pg);
+            } else if (base == "comicinfo.xml" && archive_entry_size(entry) < (1 << 20)) {
+                std::string xml(archive_entry_size(entry), '\0');
+                if (archive_read_data(archive_handle, &xml[0], xml.size()) > 0)
+                    info = parse_comic_info(xml);
+                ++idx;
+                continue;
+            }
+            archive_read_data_skip(archive_handle);
+            ++idx;
+        }
+        if (cancelled()) {
+            close();
+            return false;
+        }
+
+        // Natural sort
+        std::sort(entries.begin(), entries.end(),
+                  [](const PageEntry& a, const PageEntry& b) {
+                      return natural_sort_compare(a.name, b.name);
+                  });
+
+        // Re‑open for sequential reading
+        archive_read_free(archive_handle);
+        archive_handle = archive_read_new();
+        archive_read_support_format_all(archive_handle);
+        archive_read_support_filter_all(archive_handle);
+        archive_read_open_filename(archive_handle, path.c_str(), 10240);
+        current_entry = -1;
+
+        return !entries.empty();
+    }
+
+    // Open from a cached page index: the archive itself is only opened
+    // when a page is first read
+    void open_indexed(const std::string& path, const PageIndex& idx) {
+        close();
+        archive_path = path;
+        entries = idx.pages;
+        info = idx.info;
+    }
+
+    void close() {
+        if (archive_handle) {
+            archive_read_free(archive_handle);
+            archive_handle = nullptr;
+        }
+        entries.clear();
+        info = ComicInfo{};
+        current_entry = -1;
+        served_remotely = false;
+    }
+
+    std::vector<unsigned char> read_page(size_t page_idx) {
+        if (served_remotely) {
+            auto data = remote->raw(archive_path, static_cast<uint32_t>(page_idx));
+            // Daemon gone → carry on with a local handle
+            if (data.empty() && !remote->connected() && open_local(archive_path))
+                return read_page(page_idx);
+            return data;
+        }
+        if (page_idx >= entries.size()) return {};
+
+        size_t target_idx = entries[page_idx].index_in_archive;
+
+        if (current_entry >= static_cast<int>(target_idx) || current_entry == -1) {
+            // Need to rewind (or open for the first time, after open_indexed)
+            if (archive_handle) archive_read_free(archive_handle);
+            archive_handle = archive_read_new();
+            archive_read_support_format_all(archive_handle);
+            archive_read_support_filter_all(archive_handle);
+            archive_read_open_filename(archive_handle, archive_path.c_str(), 10240);
+            current_entry = -1;
+        }
+
+        struct archive_entry* entry;
+        while (!cancelled() && archive_read_next_header(archive_handle, &entry) == ARCHIVE_OK) {
+            ++current_entry;
+            if (static_cast<size_t>(current_entry) == target_idx) {
+                size_t sz = archive_entry_size(entry);
+                std::vector<unsigned char> data(sz);
+                ssize_t got = archive_read_data(archive_handle, data.data(), sz);
+                if (got < 0) return {};
+                return data;
+            }
+            archive_read_data_skip(archive_handle);
+        }
+        return {};
+    }
+
+    // Pixels from the daemon's shared cache; empty when not served remotely
+    DecodedPage decode_page(size_t page_idx) {
+        if (!served_remotely) return {};
+        return remote->decode(archive_path, static_cast<uint32_t>(page_idx));
+    }
+
+    size_t page_count() const { return entries.size(); }
+    const std::vector<PageEntry>& get_entries() const { return entries; }
+    const ComicInfo& comic_info() const { return info; }
+
+    // Take over an archive opened elsewhere (e.g. on a prefetch thread)
+    void swap(ArchiveReader& other) {
+        std::swap(archive_handle, other.archive_handle);
+        std::swap(archive_path, other.archive_path);
+        std::swap(entries, other.entries);
+        std::swap(info, other.info);
+        std::swap(current_entry, other.current_entry);
+        std::swap(served_remotely, other.served_remotely);
+    }
+};
+
+// ------------------------------------------------------------------
+// tcreaderd – the daemon side. One thread per client; archives and the
+// page buffers are shared. Each buffer is a sealed memfd, so clients map
+// the very same pages and nobody can modify them.
+// ------------------------------------------------------------------
+class PageDaemon {
+private:
+    struct Archive {
+        std::mutex lock;                // libarchive handles are sequential
+        ArchiveReader reader;
+        bool opened = false, ok = false;
+        uint64_t last_used = 0;
+    };
+
+    struct Buffer {
+        int fd;
+        DaemonReply info;
+        uint64_t last_used;
+    };
+
+    using Key = std::tuple<std::string, uint32_t, uint32_t>;   // file key, op, page
+
+    std::mutex mtx;
+    std::condition_variable ready;
+    std::map<std::string, std::shared_ptr<Archive>> archives;
+    std::map<Key, Buffer> buffers;
+    std::set<Key> in_flight;            // being produced by some thread
+    size_t cached_bytes = 0;
+    size_t budget_bytes;
+    uint64_t clock = 0;
+    static constexpr size_t max_archives = 16;
+    std::atomic<int> clients{ 0 };
+    std::atomic<int64_t> idle_since{ now_ms() };          // last client left
+    static constexpr int idle_exit_ms = 10 * 60 * 1000;   // no readers for this long → exit
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // What archives and buffers are keyed by: the absolute path plus the
+    // file's identity, so two clients' relative paths never meet and a
+    // file rewritten in place is not served from stale buffers. Empty for
+    // a relative path or a file that is not there.
+    static std::string file_key(const std::string& path) {
+        struct stat st;
+        if (path.empty() || path[0] != '/' || stat(path.c_str(), &st) != 0) return {};
+        return path + strfmt("\n%llx:%llx:%llx:%lld.%09ld",
+                             static_cast<unsigned long long>(st.st_dev),
+                             static_cast<unsigned long long>(st.st_ino),
+                             static_cast<unsigned long long>(st.st_size),
+                             static_cast<long long>(st.st_mtim.tv_sec), st.st_mtim.tv_nsec);
+    }
+
+    void client_gone() {
+        if (--clients == 0) idle_since = now_ms();
+    }
+
+    std::shared_ptr<Archive> archive_for(const std::string& path, const std::string& key) {
+        std::shared_ptr<Archive> a;
+        {
+            std::lock_guard<std::mutex> g(mtx);
+            auto& slot = archives[key];
+            if (!slot) slot = std::make_shared<Archive>();
+            slot->last_used = ++clock;
+            a = slot;
+
+            // Close the least recently used handles (in‑use ones stay alive)
+            while (archives.size() > max_archives) {
+                auto victim = std::min_element(archives.begin(), archives.end(),
+                    [](const auto& x, const auto& y) {
+                        return x.second->last_used < y.second->last_used;
+                    });
+                archives.erase(victim);
+            }
+        }
+        std::lock_guard<std::mutex> g(a->lock);
+        if (!a->opened) {
+            a->ok = a->reader.open_local(path);
+            a->opened = true;
+        }
+        return a->ok ? a : nullptr;
+    }
+
+    static int make_memfd(const void* data, size_t size) {
+        int fd = memfd_create("tcreader-page", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0) return -1;
+        if (!write_full_fd(fd, data, size)) {
+            ::close(fd);
+            return -1;
+        }
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+        return fd;
+    }
+
+    // Read (and for DAEMON_DECODE, decode) one page into a new memfd
+    int produce(const std::string& path, const std::string& file, uint32_t op, uint32_t page,
+                DaemonReply& rep) {
+        auto a = archive_for(path, file);
+        if (!a) return -1;
+        std::vector<unsigned char> data;
+        {
+            std::lock_guard<std::mutex> g(a->lock);
+            data = a->reader.read_page(page);
+        }
+        if (data.empty()) return -1;
+
+        if (op == DAEMON_RAW) {
+            rep.size = data.size();
+            return make_memfd(data.data(), data.size());
+        }
+        DecodedPage img = decode_image(data, 0);   // outside every lock; gray stays 1 channel
+        if (img.empty()) return -1;
+        rep.w = img.w;
+        rep.h = img.h;
+        rep.channels = img.channels;
+        rep.size = img.size();
+        return make_memfd(img.pixels.get(), img.size());
+    }
+
+    // Cached buffer for (path, op, page), producing it exactly once even
+    // when several clients ask at the same time. Returns a dup'ed fd.
+    int acquire(const std::string& path, const std::string& file, uint32_t op, uint32_t page,
+                DaemonReply& rep) {
+        Key key{ file, op, page };
+        std::unique_lock<std::mutex> g(mtx);
+        while (true) {
+            auto it = buffers.find(key);
+            if (it != buffers.end()) {
+                it->second.last_used = ++clock;
+                rep = it->second.info;
+                return dup(it->second.fd);
+            }
+            if (!in_flight.count(key)) break;
+            ready.wait(g);
+        }
+        in_flight.insert(key);
+        g.unlock();
+
+        DaemonReply made{};
+        int fd = produce(path, file, op, page, made);
+
+        g.lock();
+        in_flight.erase(key);
+        int out = -1;
+        if (fd >= 0) {
+            buffers[key] = Buffer{ fd, made, ++clock };
+            cached_bytes += made.size;
+            rep = made;
+            out = dup(fd);
+            evict_locked();
+        }
+        ready.notify_all();
+        return out;
+    }
+
+    void evict_locked() {
+        while (cached_bytes > budget_bytes && buffers.size() > 1) {
+            auto victim = std::min_element(buffers.begin(), buffers.end(),
+                [](const auto& x, const auto& y) {
+                    return x.second.last_used < y.second.last_used;
+                });
+            cached_bytes -= victim->second.info.size;
+            ::close(victim->second.fd);     // clients keep their own mappings
+            buffers.erase(victim);
+        }
+    }
+
+    void serve(int client) {
+        if (!peer_is_us(client)) {
+            ::close(client);
+            client_gone();
+            return;
+        }
+        DaemonRequest req;
+        while (read_full(client, &req, sizeof(req))) {
+            if (req.path_len > 4096) break;
+            std::string path(req.path_len, '\0');
+            if (!read_full(client, &path[0], path.size())) break;
+
+            DaemonReply rep{};
+            std::string file = file_key(path);
+            if (req.op == DAEMON_OPEN) {
+                auto a = file.empty() ? nullptr : archive_for(path, file);
+                std::string names;
+                if (a) {
+                    std::lock_guard<std::mutex> g(a->lock);
+                    for (const auto& e : a->reader.get_entries()) names += e.name + "\n";
+                }
+                rep.status = a ? 0 : 1;
+                rep.size = names.size();
+                if (!write_full(client, &rep, sizeof(rep)) ||
+                    !write_full(client, names.data(), names.size()))
+                    break;
+                continue;
+            }
+
+            int fd = !file.empty() && (req.op == DAEMON_RAW || req.op == DAEMON_DECODE)
+                         ? acquire(path, file, req.op, req.page, rep) : -1;
+            rep.status = fd >= 0 ? 0 : 1;
+            bool sent = send_with_fd(client, &rep, sizeof(rep), fd);
+            if (fd >= 0) ::close(fd);
+            if (!sent) break;
+        }
+        ::close(client);
+        client_gone();
+    }
+
+public:
+    explicit PageDaemon(size_t budget) : budget_bytes(budget) {}
+
+    int run() {
+        std::string path = daemon_socket_path();
+        int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener < 0) return 1;
+
+        struct sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        // A stale socket from a crashed daemon is replaced; a live one wins
+        DaemonClient probe;
+        if (probe.connect(false)) {
+            std::cerr << "tcreaderd already running on " << path << "\n";
+            return 1;
+        }
+        unlink(path.c_str());
+        mode_t old_mask = umask(077);       // the socket is per user
+        int rc = bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        umask(old_mask);
+        if (rc < 0 || listen(listener, 16) < 0) {
+            std::cerr << "tcreaderd: cannot listen on " << path << "\n";
+            return 1;
+        }
+
+        signal(SIGPIPE, SIG_IGN);
+        while (true) {
+            // Idle: the next reader starts a new one. The count only drops
+            // on client threads, so with readers connected look again
+            // every few seconds.
+            int64_t idle = now_ms() - idle_since;
+            if (clients == 0 && idle >= idle_exit_ms) break;
+            struct pollfd pfd{ listener, POLLIN, 0 };
+            int n = poll(&pfd, 1, clients == 0 ? static_cast<int>(idle_exit_ms - idle) : 5000);
+            if (n <= 0) continue;
+            int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            ++clients;      // before the thread starts, so it counts at once
+            std::thread(&PageDaemon::serve, this, client).detach();
+        }
+        unlink(path.c_str());
+        return 0;
+    }
+};
+
+int run_daemon(const Config& cfg) {
+    prctl(PR_SET_NAME, "tcreaderd");
+    PageDaemon daemon(cfg.daemon_cache_mb << 20);
+    return daemon.run();
+}
+
+// ------------------------------------------------------------------
+// Archive fingerprints. Caches and progress are keyed by what is in the
+// file, not where it lives: XXH64 over the size, the first 64 KB (local
+// headers, RAR main header) and the last 64 KB (the ZIP central
+// directory), so moving or renaming a comic keeps all of its state.
+// ------------------------------------------------------------------
+static uint64_t fnv1a64(const void* data, size_t len, uint64_t h = 0xcbf29ce484222325ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+namespace xxh {
+static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full,
+                          P3 = 0x165667B19E3779F9ull, P4 = 0x85EBCA77C2B2AE63ull,
+                          P5 = 0x27D4EB2F165667C5ull;
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+inline uint64_t read64(const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint32_t read32(const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint64_t round(uint64_t acc, uint64_t in) { return rotl(acc + in * P2, 31) * P1; }
+inline uint64_t merge(uint64_t acc, uint64_t v) { return (acc ^ round(0, v)) * P1 + P4; }
+}
+
+// XXH64 (little‑endian hosts)
+uint64_t xxh64(const void* data, size_t len, uint64_t seed = 0) {
+    using namespace xxh;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+    } else {
+        h = seed + P5;
+    }
+    h += len;
+    for (; p + 8 <= end; p += 8) h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+    if (p + 4 <= end) {
+        h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p) h = rotl(h ^ (*p * P5), 11) * P1;
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// 0 if the file cannot be read
+uint64_t archive_fingerprint(const std::string& path) {
+    const size_t span = 64 * 1024;
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    std::vector<unsigned char> buf(sizeof(size));
+    memcpy(buf.data(), &size, sizeof(size));
+
+    size_t head = static_cast<size_t>(std::min<uint64_t>(size, span));
+    size_t tail = static_cast<size_t>(std::min<uint64_t>(size - head, span));
+    buf.resize(sizeof(size) + head + tail);
+    bool ok = pread(fd, &buf[sizeof(size)], head, 0) == static_cast<ssize_t>(head) &&
+              pread(fd, &buf[sizeof(size) + head], tail,
+                    static_cast<off_t>(size - tail)) == static_cast<ssize_t>(tail);
+    ::close(fd);
+    if (!ok) return 0;
+    uint64_t fp = xxh64(buf.data(), buf.size());
+    return fp ? fp : 1;
+}
+
+// Hash of the canonical path – the progress key before fingerprints
+uint64_t path_identity(const std::string& path) {
+    std::error_code ec;
+    std::string canon = fs::weakly_canonical(path, ec).string();
+    if (ec) canon = path;
+    return fnv1a64(canon.data(), canon.size());
+}
+
+// ------------------------------------------------------------------
+// Cross‑process cache of scaled pages. Without a daemon, readers still
+// share work through one mapped file under $XDG_RUNTIME_DIR: a fixed
+// open‑addressing directory of seqlocked slots over a ring‑allocated data
+// area. Writers reserve space by bumping the ring head, so nothing takes
+// a lock; a reader copies an entry out and keeps it only if the head has
+// not lapped it in the meantime. Pages are held QOI‑compressed.
+// ------------------------------------------------------------------
+
+// Only the per-user runtime dir: a fixed name under /tmp could be planted
+// by someone else. Empty when there is none, which disables the cache.
+std::string shared_cache_path() {
+    const char* rt = getenv("XDG_RUNTIME_DIR");
+    if (!rt || !*rt) return {};
+    return std::string(rt) + "/tcreader-pages";
+}
+
+class SharedPageCache {
+private:
+    static constexpr uint64_t MAGIC = 0x3165676170637274ull;   // "trcpage1"
+    static constexpr uint32_t SLOTS = 1024;
+    static constexpr uint32_t PROBES = 8;
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "shared cache needs address‑free 64‑bit atomics");
+
+    struct Header {
+        uint64_t magic;
+        uint64_t data_size;
+        std::atomic<uint64_t> head;      // ring bytes ever reserved
+    };
+    struct Slot {
+        std::atomic<uint32_t> seq;       // odd while a writer owns the slot
+        std::atomic<uint32_t> w, h;
+        std::atomic<uint64_t> key, pos, size;
+    };
+    struct EntryHeader {
+        uint64_t key, size;
+    };
+
+    void* base = nullptr;
+    size_t mapped = 0;
+    Header* hdr = nullptr;
+    Slot* slots = nullptr;
+    unsigned char* data = nullptr;
+
+    static size_t align64(size_t n) { return (n + 63) & ~size_t(63); }
+
+    // An entry reserved at `pos` survives until the head passes pos + data
+    bool live(uint64_t pos) const {
+        return hdr->head.load(std::memory_order_acquire) <= pos + hdr->data_size;
+    }
+
+    // Reserve `need` contiguous bytes, skipping the tail of the ring if the
+    // entry would straddle its end. Returns the absolute ring position.
+    uint64_t reserve(size_t need) {
+        uint64_t cur = hdr->head.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t off = cur % hdr->data_size;
+            uint64_t start = off + need > hdr->data_size ? cur + (hdr->data_size - off) : cur;
+            if (hdr->head.compare_exchange_weak(cur, start + need,
+                                                std::memory_order_acq_rel))
+                return start;
+        }
+    }
+
+public:
+    ~SharedPageCache() { close(); }
+
+    bool open(const std::string& path, size_t bytes) {
+        close();
+        if (path.empty()) return false;
+        // Create exclusively, else open what is there without following a
+        // link, and trust it only if it is our own private regular file
+        const int flags = O_RDWR | O_CLOEXEC | O_NOFOLLOW;
+        int fd = ::open(path.c_str(), flags | O_CREAT | O_EXCL, 0600);
+        if (fd < 0 && errno == EEXIST) fd = ::open(path.c_str(), flags);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != getuid() ||
+            (st.st_mode & (S_IRWXG | S_IRWXO))) {
+            ::close(fd);
+            return false;
+        }
+        flock(fd, LOCK_EX);   // only while sizing / initialising
+
+        size_t dir_bytes = align64(sizeof(Header)) + align64(SLOTS * sizeof(Slot));
+        bool fresh = fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= dir_bytes;
+        size_t size = fresh ? dir_bytes + align64(bytes) : static_cast<size_t>(st.st_size);
+        if (fresh && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            base = p;
+            mapped = size;
+            hdr = static_cast<Header*>(p);
+            slots = reinterpret_cast<Slot*>(static_cast<char*>(p) + align64(sizeof(Header)));
+            data = static_cast<unsigned char*>(p) + dir_bytes;
+            if (fresh || hdr->magic != MAGIC || hdr->data_size != size - dir_bytes) {
+                memset(p, 0, dir_bytes);
+                hdr->data_size = size - dir_bytes;
+                hdr->magic = MAGIC;
+            }
+        }
+        flock(fd, LOCK_UN);
+        ::close(fd);   // the mapping stays valid
+        return base != nullptr;
+    }
+
+    void close() {
+        if (base) munmap(base, mapped);
+        base = nullptr;
+        hdr = nullptr;
+    }
+
+    bool is_open() const { return base != nullptr; }
+
+    static uint64_t make_key(uint64_t fingerprint, int page, int w, int h, int channels = 3,
+                             int style = 0) {
+        int32_t parts[5] = { page, w, h, channels, style };
+        uint64_t k = fnv1a64(parts, sizeof(parts), fingerprint);
+        return k ? k : 1;   // 0 marks an empty slot
+    }
+
+    // Copy a cached w×h page out; false on miss or if it was overwritten
+    bool get(uint64_t key, int w, int h, std::vector<unsigned char>& pixels,
+             int channels = 3) const {
+        std::vector<unsigned char> packed;
+        if (!base) return false;
+        for (uint32_t i = 0; i < PROBES; ++i) {
+            const Slot& s = slots[(key + i) % SLOTS];
+            uint32_t s1 = s.seq.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            uint64_t k = s.key.load(std::memory_order_relaxed);
+            uint64_t pos = s.pos.load(std::memory_order_relaxed);
+            uint64_t size = s.size.load(std::memory_order_relaxed);
+            uint32_t sw = s.w.load(std::memory_order_relaxed);
+            uint32_t sh = s.h.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != s1 || k != key) continue;
+            if (static_cast<int>(sw) != w || static_cast<int>(sh) != h ||
+                size > hdr->data_size || !live(pos))
+                return false;
+
+            // Copy the compressed bytes first, decode once they proved stable
+            const unsigned char* src = data + pos % hdr->data_size;
+            EntryHeader eh;
+            memcpy(&eh, src, sizeof(eh));
+            packed.resize(size);
+            memcpy(packed.data(), src + sizeof(eh), size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return eh.key == key && eh.size == size && live(pos) &&
+                   decode_qoi(packed.data(), packed.size(), w, h, pixels, channels);
+        }
+        return false;
+    }
+
+    // Publish a page; best effort – a contended or oversized entry is dropped
+    void put(uint64_t key, int w, int h, const std::vector<unsigned char>& pixels,
+             int channels = 3) {
+        if (!base) return;
+        std::vector<unsigned char> packed = encode_qoi(pixels.data(), w, h, channels);
+        size_t need = align64(sizeof(EntryHeader) + packed.size());
+        if (need > hdr->data_size / 4) return;
+
+        uint64_t pos = reserve(need);
+        unsigned char* dst = data + pos % hdr->data_size;
+        EntryHeader eh{ key, packed.size() };
+        memcpy(dst, &eh, sizeof(eh));
+        memcpy(dst + sizeof(eh), packed.data(), packed.size());
+
+        // Same key, an empty or lapped slot, else the oldest of the probe run
+        Slot* victim = nullptr;
+        uint64_t oldest = UINT64_MAX;
+        for (uint32_t i = 0; i < PROBES; ++i) {
+            Slot& s = slots[(key + i) % SLOTS];
+            uint64_t k = s.key.load(std::memory_order_relaxed);
+            uint64_t p = s.pos.load(std::memory_order_relaxed);
+            if (k == key || k == 0 || !live(p)) {
+                victim = &s;
+                break;
+            }
+            if (p < oldest) {
+                oldest = p;
+                victim = &s;
+            }
+        }
+
+        uint32_t seq = victim->seq.load(std::memory_order_relaxed);
+        if ((seq & 1) || !victim->seq.compare_exchange_strong(seq, seq + 1,
+                                                              std::memory_order_acq_rel))
+            return;
+        std::atomic_thread_fence(std::memory_order_release);
+        victim->key.store(key, std::memory_order_relaxed);
+        victim->pos.store(pos, std::memory_order_relaxed);
+        victim->size.store(packed.size(), std::memory_order_relaxed);
+        victim->w.store(static_cast<uint32_t>(w), std::memory_order_relaxed);
+        victim->h.store(static_cast<uint32_t>(h), std::memory_order_relaxed);
+        victim->seq.store(seq + 2, std::memory_order_release);
+    }
+};
+
+// ------------------------------------------------------------------
+// Persistent cache of rendered pages (~/.cache/tcreader/renders). Each
+// file is one scaled and cropped rendition as a QOI image, so loading it
+// is a read plus a fast decode instead of a JPEG decode and resize. File
+// mtimes double as LRU stamps, so readers sharing the directory age
+// entries consistently.
+// ------------------------------------------------------------------
+class RenderCache {
+private:
+    struct Entry {
+        size_t bytes;
+        int64_t stamp;   // last use, seconds
+    };
+    std::string dir;
+    std::map<std::string, Entry> entries;   // file name → entry
+    std::set<std::pair<int64_t, std::string>> by_age;   // (stamp, name), oldest first
+    size_t total_bytes = 0;
+    size_t budget_bytes = 0;
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Add or refresh an entry; `entries`, `by_age` and the byte count
+    // only change together
+    void put(const std::string& name, size_t bytes, int64_t stamp) {
+        auto it = entries.find(name);
+        if (it != entries.end()) drop(it);
+        entries[name] = { bytes, stamp };
+        by_age.emplace(stamp, name);
+        total_bytes += bytes;
+    }
+
+    void drop(std::map<std::string, Entry>::iterator it) {
+        total_bytes -= it->second.bytes;
+        by_age.erase({ it->second.stamp, it->first });
+        entries.erase(it);
+    }
+
+    void evict() {
+        while (total_bytes > budget_bytes && !by_age.empty()) {
+            const std::string& oldest = by_age.begin()->second;
+            unlink((dir + "/" + oldest).c_str());
+            drop(entries.find(oldest));
+        }
+    }
+
+public:
+    bool open(const std::string& path, size_t budget) {
+        std::error_code ec;
+        fs::create_directories(path, ec);
+        if (ec) return false;
+        dir = path;
+        budget_bytes = budget;
+        entries.clear();
+        by_age.clear();
+        total_bytes = 0;
+        for (const auto& e : fs::directory_iterator(dir, ec)) {
+            struct stat st;
+            if (stat(e.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+            put(e.path().filename().string(), st.st_size, st.st_mtim.tv_sec);
+        }
+        evict();
+        return true;
+    }
+
+    bool is_open() const { return !dir.empty(); }
+
+    // One file per archive, page, scaled size and visible crop; grayscale
+    // renditions are marked "-g"
+    static std::string key(uint64_t fingerprint, int page, int new_w, int new_h,
+                           int crop_x, int crop_y, int crop_w, int crop_h,
+                           int channels = 3, int style = 0) {
+        return strfmt("%016llx-%d-%dx%d-%d.%d.%dx%d%s%s%s.qoi",
+                      static_cast<unsigned long long>(fingerprint),
+                      page, new_w, new_h, crop_x, crop_y, crop_w, crop_h,
+                      channels == 1 ? "-g" : "",
+                      style & STYLE_SRGB ? "-s" : "",
+                      style & STYLE_DESCREEN ? "-d" : "");
+    }
+
+    // `entries` is a snapshot from open(), so a miss there still looks on
+    // disk for a rendition another reader has written since
+    bool load(const std::string& name, int w, int h, std::vector<unsigned char>& pixels,
+              int channels = 3) {
+        if (dir.empty()) return false;
+        int fd = ::open((dir + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            auto it = entries.find(name);
+            if (it != entries.end()) drop(it);   // evicted by another reader
+            return false;
+        }
+        struct stat st;
+        std::vector<unsigned char> packed;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok) {
+            packed.resize(st.st_size);
+            ok = read_full(fd, packed.data(), packed.size()) &&
+                 decode_qoi(packed.data(), packed.size(), w, h, pixels, channels);
+        }
+        if (ok) {
+            futimens(fd, nullptr);   // bump the LRU stamp
+            put(name, st.st_size, now());
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    // Write via a temporary file so a concurrent reader never sees half a page
+    void store(const std::string& name, int w, int h, const std::vector<unsigned char>& pixels,
+               int channels = 3) {
+        if (dir.empty() || entries.count(name) || on_disk(name)) return;
+        std::string path = dir + "/" + name;
+        std::string tmp = path + strfmt(".%d.tmp", static_cast<int>(getpid()));
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) return;
+        std::vector<unsigned char> packed = encode_qoi(pixels.data(), w, h, channels);
+        bool ok = write_full_fd(fd, packed.data(), packed.size());
+        ::close(fd);
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+            unlink(tmp.c_str());
+            return;
+        }
+        put(name, packed.size(), now());
+        evict();
+    }
+
+    bool contains(const std::string& name) const { return entries.count(name) > 0; }
+
+    // Safe off the main thread: asks the file system, not the index
+    bool on_disk(const std::string& name) const {
+        return !dir.empty() && access((dir + "/" + name).c_str(), F_OK) == 0;
+    }
+    size_t size_bytes() const { return total_bytes; }
+};
+
+// ------------------------------------------------------------------
+// Page geometry: a page scaled to fit a pixel box (times zoom). The box
+// is the terminal's pixel area less status_line_px, or half its width
+// for a spread.
+// ------------------------------------------------------------------
+constexpr int status_line_px = 100;
+
+void fit_page(int w, int h, int box_w, int box_h, float zoom, int& new_w, int& new_h) {
+    float scale = std::min(static_cast<float>(box_w) / w,
+                           static_cast<float>(box_h) / h) * zoom;
+    new_w = std::max(1, static_cast<int>(w * scale));
+    new_h = std::max(1, static_cast<int>(h * scale));
+}
+
+// ------------------------------------------------------------------
+// Page index cache (~/.cache/tcreader/index/<fingerprint>): the sorted
+// page list, ComicInfo.xml hints and header dimensions of an archive, so
+// opening it again needs no walk over its headers – for solid RAR files
+// that walk decompresses the whole archive.
+// ------------------------------------------------------------------
+class PageIndexCache {
+private:
+    std::string dir;
+
+    std::string file_for(uint64_t fp) const {
+        return dir + strfmt("/%016llx", static_cast<unsigned long long>(fp));
+    }
+
+    static std::string clean(std::string s) {
+        std::replace_if(s.begin(), s.end(),
+                        [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+        return s;
+    }
+
+public:
+    bool open(const std::string& path) {
+        std::error_code ec;
+        fs::create_directories(path, ec);
+        if (ec) return false;
+        dir = path;
+        return true;
+    }
+
+    bool is_open() const { return !dir.empty(); }
+
+    bool load(uint64_t fp, PageIndex& idx) const {
+        if (dir.empty() || !fp) return false;
+        std::ifstream file(file_for(fp));
+        std::string line;
+        if (!std::getline(file, line) || line != "tcreader-index 1") return false;
+
+        idx = PageIndex{};
+        while (std::getline(file, line)) {
+            std::vector<std::string> f;
+            std::istringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, '\t')) f.push_back(field);
+            if (f.size() == 5 && f[0] == "page") {
+                idx.pages.push_back({ f[4], std::strtoul(f[1].c_str(), nullptr, 10) });
+                idx.dims.emplace_back(std::atoi(f[2].c_str()), std::atoi(f[3].c_str()));
+            } else if (f.size() >= 5 && f[0] == "info") {
+                idx.info.series = f[1];
+                idx.info.number = f[2];
+                idx.info.title = f[3];
+                idx.info.page_count = std::atoi(f[4].c_str());
+            } else if (f.size() == 2 && (f[0] == "double" || f[0] == "cover")) {
+                std::set<int>& pages = f[0] == "double" ? idx.info.double_pages
+                                                        : idx.info.covers;
+                std::istringstream list(f[1]);
+                while (std::getline(list, field, ',')) pages.insert(std::atoi(field.c_str()));
+            } else if (f.size() == 1 && f[0] == "has_pages") {
+                idx.info.has_pages = true;
+            }
+        }
+        return !idx.pages.empty();
+    }
+
+    void store(uint64_t fp, const PageIndex& idx) const {
+        if (dir.empty() || !fp || idx.pages.empty()) return;
+        std::string path = file_for(fp);
+        std::string tmp = path + strfmt(".%d.%zu.tmp", static_cast<int>(getpid()),
+                                        std::hash<std::thread::id>()(std::this_thread::get_id()));
+        {
+            std::ofstream file(tmp, std::ios::trunc);
+            if (!file.is_open()) return;
+            const ComicInfo& info = idx.info;
+            file << "tcreader-index 1\n"
+                 << "info\t" << clean(info.series) << '\t' << clean(info.number) << '\t'
+                 << clean(info.title) << '\t' << info.page_count << '\n';
+            if (info.has_pages) file << "has_pages\n";
+            for (const auto* set : { &info.double_pages, &info.covers }) {
+                if (set->empty()) continue;
+                file << (set == &info.double_pages ? "double\t" : "cover\t");
+                for (auto it = set->begin(); it != set->end(); ++it)
+                    file << (it == set->begin() ? "" : ",") << *it;
+                file << '\n';
+            }
+            for (size_t i = 0; i < idx.pages.size(); ++i) {
+                auto wh = i < idx.dims.size() ? idx.dims[i] : std::make_pair(0, 0);
+                file << "page\t" << idx.pages[i].index_in_archive << '\t' << wh.first
+                     << '\t' << wh.second << '\t' << clean(idx.pages[i].name) << '\n';
+            }
+        }
+        if (rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+    }
+};
+
+// ------------------------------------------------------------------
+// Terminal‑side image store. Kitty keeps every image transmitted with an
+// id until it is deleted (a=d), so track what we left there and evict it
+// under a byte budget, the same way page_cache is trimmed locally.
+// ------------------------------------------------------------------
+struct KittyImage {
+    uint32_t id;
+    int page;
+    size_t bytes;
+    uint64_t last_used;
+    bool reduced;       // low‑quality preview still waiting for refinement
+};
+
+class KittyImageStore {
+private:
+    std::map<std::string, KittyImage> images;   // render key → image
+    size_t total_bytes = 0;
+    uint64_t clock = 0;
+    uint32_t next_id;
+
+public:
+    size_t budget_bytes = 0;
+
+    // Start ids at a per‑process offset so two readers sharing one Kitty
+    // window do not delete each other's images.
+    KittyImageStore() : next_id((static_cast<uint32_t>(getpid()) & 0xffff) << 12) {}
+
+    const KittyImage* find(const std::string& key) {
+        auto it = images.find(key);
+        if (it == images.end()) return nullptr;
+        it->second.last_used = ++clock;
+        return &it->second;
+    }
+
+    // Record a transmission; re‑sending a known key keeps its id so the
+    // terminal replaces the old pixels in place.
+    uint32_t put(const std::string& key, int page, size_t bytes, bool reduced) {
+        auto it = images.find(key);
+        if (it != images.end()) {
+            total_bytes = total_bytes - it->second.bytes + bytes;
+            it->second.bytes = bytes;
+            it->second.reduced = reduced;
+            it->second.last_used = ++clock;
+            return it->second.id;
+        }
+        if (++next_id == 0) ++next_id;
+        images[key] = KittyImage{ next_id, page, bytes, ++clock, reduced };
+        total_bytes += bytes;
+        return next_id;
+    }
+
+    // Pick images to delete until we are within budget. Images shown right
+    // now are never evicted; pages within `radius` of the current one are
+    // kept over the rest, and least recently used goes first.
+    std::vector<uint32_t> evict(int current_page, int radius,
+                                const std::vector<uint32_t>& on_screen) {
+        std::vector<uint32_t> victims;
+        if (total_bytes <= budget_bytes) return victims;
+
+        std::vector<std::map<std::string, KittyImage>::iterator> order;
+        for (auto it = images.begin(); it != images.end(); ++it)
+            if (std::find(on_screen.begin(), on_screen.end(), it->second.id) == on_screen.end())
+                order.push_back(it);
+
+        auto near = [&](const KittyImage& img) {
+            return std::abs(img.page - current_page) <= radius;
+        };
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) {
+            if (near(a->second) != near(b->second)) return !near(a->second);
+            return a->second.last_used < b->second.last_used;
+        });
+
+        for (auto it : order) {
+            if (total_bytes <= budget_bytes) break;
+            victims.push_back(it->second.id);
+            total_bytes -= it->second.bytes;
+            images.erase(it);
+        }
+        return victims;
+    }
+
+    // Whether the image with this id is a preview awaiting refinement
+    bool is_reduced(uint32_t id) const {
+        for (const auto& [_, img] : images)
+            if (img.id == id) return img.reduced;
+        return false;
+    }
+
+    // Forget an image whose transfer was abandoned
+    void erase_id(uint32_t id) {
+        for (auto it = images.begin(); it != images.end(); ++it) {
+            if (it->second.id == id) {
+                total_bytes -= it->second.bytes;
+                images.erase(it);
+                return;
+            }
+        }
+    }
+
+    std::vector<uint32_t> clear() {
+        std::vector<uint32_t> ids;
+        for (const auto& [_, img] : images) ids.push_back(img.id);
+        images.clear();
+        total_bytes = 0;
+        return ids;
+    }
+};
+
+// ------------------------------------------------------------------
+// Reading progress, keyed by archive fingerprint rather than file name.
+// The store is an append‑only log of fixed‑size records: a page turn
+// appends one record (a single O_APPEND write), the newest record per
+// key wins, and the log is compacted on load once it is mostly stale.
+// Appends hold a shared flock on the log and compaction an exclusive
+// one, so a record written by another instance mid‑compaction is
+// either read into the new log or appended to it after the rename.
+// It is read on first use, not at startup. Entries from the old
+// ~/.tcreader_progress.json are picked up by file name and migrated the
+// first time that comic is opened.
+// ------------------------------------------------------------------
+struct Progress {
+    int page = 0;
+    int total = 0;
+    int64_t last_read = 0;   // unix time
+    bool completed = false;
+};
+
+class ProgressStore {
+private:
+    static constexpr char MAGIC[8] = { 'T', 'C', 'P', 'R', 'O', 'G', '1', '\n' };
+
+    struct Record {
+        uint64_t key;
+        int64_t last_read;
+        int32_t page, total;
+        uint32_t flags;      // bit 0: completed
+        uint32_t check;      // crc32 of the fields above (drops torn writes)
+    };
+    static_assert(sizeof(Record) == 32, "progress record layout");
+
+    std::string path, legacy_path;
+    std::map<uint64_t, Progress> entries;
+    off_t read_to = 0;     // log bytes already applied to `entries`
+    SimpleJSON legacy;
+    bool loaded = false;
+
+    static uint32_t checksum(const Record& r) {
+        return static_cast<uint32_t>(
+            crc32(0L, reinterpret_cast<const Bytef*>(&r), offsetof(Record, check)));
+    }
+
+    static Record to_record(uint64_t key, const Progress& p) {
+        Record r{ key, p.last_read, p.page, p.total, p.completed ? 1u : 0u, 0 };
+        r.check = checksum(r);
+        return r;
+    }
+
+    // Apply records from `read_to` to the end of the log; returns how
+    // many were read
+    size_t read_log(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) return 0;
+        off_t start = read_to;
+        if (start == 0) {
+            char magic[sizeof(MAGIC)];
+            if (st.st_size < static_cast<off_t>(sizeof(MAGIC)) ||
+                pread(fd, magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic)) ||
+                memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+                return 0;
+            start = sizeof(MAGIC);
+        }
+        size_t count = (st.st_size - std::min(start, st.st_size)) / sizeof(Record);
+        std::vector<Record> recs(count);
+        if (count == 0 || pread(fd, recs.data(), count * sizeof(Record), start) !=
+                              static_cast<ssize_t>(count * sizeof(Record)))
+            return 0;
+        for (const Record& r : recs) {
+            if (r.check != checksum(r)) continue;
+            entries[r.key] = { r.page, r.total, r.last_read, (r.flags & 1) != 0 };
+        }
+        read_to = start + count * sizeof(Record);
+        return count;
+    }
+
+    // Whether `fd` is still the file at `path` (a compaction replaces it)
+    bool is_current(int fd) const {
+        struct stat a, b;
+        return fstat(fd, &a) == 0 && stat(path.c_str(), &b) == 0 &&
+               a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+    }
+
+    void load() {
+        loaded = true;
+        legacy.load(legacy_path);
+
+        size_t records = 0;
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            flock(fd, LOCK_SH);
+            records = read_log(fd);
+            ::close(fd);
+        }
+        if (records > 2 * entries.size() + 1024) compact();
+    }
+
+    // Rewrite the log with one record per comic. Under the exclusive lock
+    // nothing else appends, so records added since load() are picked up
+    // first and none are lost by the rename.
+    void compact() {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        if (flock(fd, LOCK_EX) != 0 || !is_current(fd)) {   // compacted by someone else
+            ::close(fd);
+            return;
+        }
+        read_log(fd);
+
+        std::string tmp = path + ".XXXXXX";
+        int out_fd = mkstemp(&tmp[0]);
+        if (out_fd < 0) {
+            ::close(fd);
+            return;
+        }
+        std::vector<Record> all;
+        all.reserve(entries.size());
+        for (const auto& [key, p] : entries) all.push_back(to_record(key, p));
+        bool ok = write_full_fd(out_fd, MAGIC, sizeof(MAGIC)) &&
+                  write_full_fd(out_fd, all.data(), all.size() * sizeof(Record));
+        ::close(out_fd);
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+        else read_to = sizeof(MAGIC) + all.size() * sizeof(Record);
+        ::close(fd);   // drops the lock; waiting appenders reopen the new log
+    }
+
+public:
+    void open(const std::string& log_path, const std::string& old_json_path) {
+        path = log_path;
+        legacy_path = old_json_path;
+    }
+
+    // `path_key` and `name` only find entries written before archives
+    // were fingerprinted (path‑keyed log records, the old JSON file)
+    bool get(uint64_t key, uint64_t path_key, const std::string& name, Progress& p) {
+        if (!loaded) load();
+        for (uint64_t k : { key, path_key }) {
+            auto it = entries.find(k);
+            if (it != entries.end()) {
+                p = it->second;
+                return true;
+            }
+        }
+        auto old = legacy.data.find(name);
+        if (old == legacy.data.end()) return false;
+        p = Progress{};
+        p.page = old->second;
+        return true;
+    }
+
+    // Append a record if anything but the timestamp changed
+    void put(uint64_t key, const Progress& p) {
+        if (path.empty()) return;
+        if (!loaded) load();
+        auto it = entries.find(key);
+        if (it != entries.end() && it->second.page == p.page &&
+            it->second.total == p.total && it->second.completed == p.completed)
+            return;
+        entries[key] = p;
+
+        // A log renamed over while we waited for the lock is reopened
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+            if (fd < 0) return;
+            flock(fd, LOCK_SH);
+            if (!is_current(fd)) {
+                ::close(fd);
+                continue;
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size == 0)
+                write_full_fd(fd, MAGIC, sizeof(MAGIC));
+            Record r = to_record(key, p);
+            write_full_fd(fd, &r, sizeof(r));
+            ::close(fd);
+            return;
+        }
+    }
+};
+
+// ------------------------------------------------------------------
+// Library index: what we know about each comic opened so far (series,
+// issue, title, pages), keyed by fingerprint and kept as a tab‑separated
+// file in the cache directory. Rewritten only when an entry changes.
+// ------------------------------------------------------------------
+struct LibraryEntry {
+    std::string path;
+    std::string series, number, title;
+    int pages = 0;
+};
+
+class LibraryIndex {
+private:
+    std::string path;
+    std::map<uint64_t, LibraryEntry> entries;
+    std::map<std::string, uint64_t> by_path;   // kept in step with entries
+    bool loaded = false;
+    bool dirty = false;
+
+    static std::string clean(std::string s) {
+        std::replace_if(s.begin(), s.end(),
+                        [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+        return s;
+    }
+
+    void load() {
+        loaded = true;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> f;
+            std::istringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, '\t')) f.push_back(field);
+            if (f.size() < 6) continue;
+            uint64_t fp = std::strtoull(f[0].c_str(), nullptr, 16);
+            entries[fp] = { f[1], f[2], f[3], f[4], std::atoi(f[5].c_str()) };
+            by_path[f[1]] = fp;
+        }
+    }
+
+    void save() {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream file(tmp, std::ios::trunc);
+            if (!file.is_open()) return;
+            for (const auto& [fp, e] : entries)
+                file << strfmt("%016llx", static_cast<unsigned long long>(fp)) << '\t'
+                     << e.path << '\t' << e.series << '\t' << e.number << '\t'
+                     << e.title << '\t' << e.pages << '\n';
+        }
+        if (rename(tmp.c_str(), path.c_str()) != 0) unlink(tmp.c_str());
+    }
+
+public:
+    void open(const std::string& file) { path = file; }
+
+    const LibraryEntry* find(uint64_t fp) {
+        if (!loaded) load();
+        auto it = entries.find(fp);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    const std::map<uint64_t, LibraryEntry>& all() {
+        if (!loaded) load();
+        return entries;
+    }
+
+    // Look up by where the comic was last seen (no fingerprint needed)
+    const LibraryEntry* find_path(const std::string& file) {
+        if (!loaded) load();
+        auto it = by_path.find(file);
+        if (it == by_path.end()) return nullptr;
+        auto e = entries.find(it->second);
+        return e == entries.end() || e->second.path != file ? nullptr : &e->second;
+    }
+
+    // write=false batches updates until flush() (e.g. `tcreader warm`)
+    void update(uint64_t fp, const std::string& file, const ComicInfo& info, int pages,
+                bool write = true) {
+        if (path.empty() || !fp) return;
+        if (!loaded) load();
+        LibraryEntry e{ clean(file), clean(info.series), clean(info.number),
+                        clean(info.title), pages };
+        auto it = entries.find(fp);
+        if (it != entries.end() && it->second.path == e.path &&
+            it->second.series == e.series && it->second.number == e.number &&
+            it->second.title == e.title && it->second.pages == e.pages)
+            return;
+        // A rewritten file gets a new fingerprint; drop its old entry, and
+        // the path this fingerprint was last seen at
+        auto old = by_path.find(e.path);
+        if (old != by_path.end() && old->second != fp) entries.erase(old->second);
+        if (it != entries.end() && it->second.path != e.path) {
+            auto prev = by_path.find(it->second.path);
+            if (prev != by_path.end() && prev->second == fp) by_path.erase(prev);
+        }
+        entries[fp] = e;
+        by_path[e.path] = fp;
+        dirty = true;
+        if (write) flush();
+    }
+
+    void flush() {
+        if (dirty) save();
+        dirty = false;
+    }
+};
+
+// ------------------------------------------------------------------
+// Optional telemetry log (telemetry = true): one tab‑separated line per
+// page shown and per reading session, appended to
+// cache_dir()/telemetry.tsv. Columns:
+//   page     time archive format backend terminal page extract_ms
+//            decode_ms resize_ms emit_ms bytes tier name
+//   session  time archive format backend terminal pages seconds bytes name
+// `tier` is where the pixels came from: terminal (already resident),
+// disk (render cache), shm (shared cache), prefetch, daemon, memory
+// (raw page cached) or archive.
+// ------------------------------------------------------------------
+struct PageEvent {
+    int page = 0;
+    double extract_ms = 0, decode_ms = 0, resize_ms = 0, emit_ms = 0;
+    size_t bytes = 0;
+    std::string tier;
+};
+
+class TelemetryLog {
+private:
+    int fd = -1;
+    std::string terminal;
+
+    static std::string clean(std::string s) {
+        std::replace_if(s.begin(), s.end(),
+                        [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+        return s;
+    }
+
+    void append(const std::string& line) {
+        // One write per line: O_APPEND keeps concurrent readers' lines whole
+        if (fd >= 0 && write(fd, line.data(), line.size()) < 0) {}
+    }
+
+public:
+    struct Archive {
+        uint64_t fp = 0;
+        std::string format;      // file extension: cbz, cbr, zip
+        std::string name;
+        std::string backend;
+    };
+
+    ~TelemetryLog() { if (fd >= 0) close(fd); }
+
+    void open(const std::string& path) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        const char* prog = getenv("TERM_PROGRAM");
+        const char* term = getenv("TERM");
+        terminal = clean(prog && *prog ? prog : term ? term : "unknown");
+    }
+
+    bool enabled() const { return fd >= 0; }
+
+    static Archive archive(uint64_t fp, const std::string& path, RenderMode mode) {
+        static const char* backends[] = { "kitty", "iterm2", "timg", "ascii" };
+        Archive a;
+        a.fp = fp;
+        a.format = fs::path(path).extension().string();
+        if (!a.format.empty()) a.format.erase(0, 1);
+        std::transform(a.format.begin(), a.format.end(), a.format.begin(), ::tolower);
+        a.name = clean(fs::path(path).filename().string());
+        a.backend = backends[static_cast<int>(mode)];
+        return a;
+    }
+
+    void page(const Archive& a, const PageEvent& e) {
+        if (fd < 0) return;
+        append(strfmt("page\t%lld\t%016llx\t%s\t%s\t%s\t%d\t%.2f\t%.2f\t%.2f\t%.2f\t%zu\t%s\t%s\n",
+                      static_cast<long long>(time(nullptr)),
+                      static_cast<unsigned long long>(a.fp), a.format.c_str(),
+                      a.backend.c_str(), terminal.c_str(), e.page, e.extract_ms,
+                      e.decode_ms, e.resize_ms, e.emit_ms, e.bytes,
+                      e.tier.c_str(), a.name.c_str()));
+    }
+
+    void session(const Archive& a, int pages, double seconds, size_t bytes) {
+        if (fd < 0) return;
+        append(strfmt("session\t%lld\t%016llx\t%s\t%s\t%s\t%d\t%.1f\t%zu\t%s\n",
+                      static_cast<long long>(time(nullptr)),
+                      static_cast<unsigned long long>(a.fp), a.format.c_str(),
+                      a.backend.c_str(), terminal.c_str(), pages, seconds, bytes,
+                      a.name.c_str()));
+    }
+};
+
+// ------------------------------------------------------------------
+// `tcreader stats [file]`: percentiles of the telemetry log per archive
+// format, per backend/terminal and per cache tier, and the archives
+// that are slowest to show (candidates for converting ahead of time).
+// Page time is extract + decode + resize + emit.
+// ------------------------------------------------------------------
+int run_stats(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "No telemetry log at " << path << " (set telemetry = true)\n";
+        return 1;
+    }
+
+    struct Sample { double total, extract, decode, resize, emit; };
+    struct Sessions { int count = 0, pages = 0; double seconds = 0; };
+    std::map<std::string, std::vector<Sample>> by_format, by_backend, by_tier, by_archive;
+    std::map<std::string, Sessions> sessions;
+    size_t page_rows = 0;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> f;
+        std::istringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, '\t')) f.push_back(field);
+        if (f.size() == 14 && f[0] == "page") {
+            Sample s{ 0, std::atof(f[7].c_str()), std::atof(f[8].c_str()),
+                      std::atof(f[9].c_str()), std::atof(f[10].c_str()) };
+            s.total = s.extract + s.decode + s.resize + s.emit;
+            by_format[f[3]].push_back(s);
+            by_backend[f[4] + "@" + f[5]].push_back(s);
+            by_tier[f[12]].push_back(s);
+            by_archive[f[13] + " (" + f[3] + ")"].push_back(s);
+            ++page_rows;
+        } else if (f.size() == 10 && f[0] == "session") {
+            Sessions& t = sessions[f[3]];
+            ++t.count;
+            t.pages += std::atoi(f[6].c_str());
+            t.seconds += std::atof(f[7].c_str());
+        }
+    }
+    if (page_rows == 0) {
+        std::cout << "No page events in " << path << "\n";
+        return 0;
+    }
+
+    auto pct = [](std::vector<double> v, double q) {
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, static_cast<size_t>(q * v.size()))];
+    };
+    auto column = [](const std::vector<Sample>& v, double Sample::*m) {
+        std::vector<double> out;
+        for (const Sample& s : v) out.push_back(s.*m);
+        return out;
+    };
+    auto table = [&](const char* title, const std::map<std::string, std::vector<Sample>>& groups) {
+        std::cout << "\n" << title << "\n"
+                  << strfmt("  %-24s %7s %8s %8s %8s   %s\n", "", "pages", "p50 ms",
+                            "p90 ms", "p99 ms", "p50 extract/decode/resize/emit");
+        for (const auto& [name, v] : groups) {
+            std::vector<double> total = column(v, &Sample::total);
+            std::cout << strfmt("  %-24s %7zu %8.1f %8.1f %8.1f   %.1f/%.1f/%.1f/%.1f\n",
+                                name.empty() ? "-" : name.c_str(), v.size(),
+                                pct(total, 0.5), pct(total, 0.9), pct(total, 0.99),
+                                pct(column(v, &Sample::extract), 0.5),
+                                pct(column(v, &Sample::decode), 0.5),
+                                pct(column(v, &Sample::resize), 0.5),
+                                pct(column(v, &Sample::emit), 0.5));
+        }
+    };
+
+    std::cout << page_rows << " pages from " << path << "\n";
+    table("By archive format", by_format);
+    table("By backend@terminal", by_backend);
+    table("By cache tier", by_tier);
+
+    if (!sessions.empty()) {
+        std::cout << "\nSessions\n";
+        for (const auto& [format, t] : sessions)
+            std::cout << strfmt("  %-24s %7d sessions, %d pages, %.1f pages/min\n",
+                                format.c_str(), t.count, t.pages,
+                                t.seconds > 0 ? t.pages * 60.0 / t.seconds : 0.0);
+    }
+
+    // Slowest archives by p90, ignoring ones with too few pages to judge
+    std::vector<std::pair<double, std::string>> slow;
+    for (const auto& [name, v] : by_archive)
+        if (v.size() >= 3) slow.emplace_back(pct(column(v, &Sample::total), 0.9), name);
+    std::sort(slow.rbegin(), slow.rend());
+    if (!slow.empty()) {
+        std::cout << "\nSlowest archives (p90 page time)\n";
+        for (size_t i = 0; i < std::min<size_t>(10, slow.size()); ++i)
+            std::cout << strfmt("  %8.1f ms  %s\n", slow[i].first, slow[i].second.c_str());
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------------
+// File‑system entry used for the directory browser
+// ------------------------------------------------------------------
+struct FileEntry {
+    std::string name;
+    std::string full_path;
+    bool is_directory;
+};
+
+// ------------------------------------------------------------------
+// Fuzzy search over every archive under the library paths. Candidates
+// are the path relative to their library root plus any series / title
+// from the library index. The library is walked on a DirScanner thread
+// and handed over in batches through add(), so a query runs against what
+// has arrived so far; finish() sorts the list once the walk is complete.
+// Matching is a subsequence scan with fzf‑style
+// bonuses, after a 64‑bit character‑set prefilter that rejects most
+// candidates in one AND; the forward scan uses memchr (vectorised in
+// libc) over search texts packed into one buffer. Typing on from a
+// query only rescans its matches, and each prefix's matches are kept so
+// backspace costs nothing.
+// ------------------------------------------------------------------
+class LibrarySearch {
+public:
+    struct Candidate {
+        std::string path;    // archive on disk
+        std::string label;   // what the result list shows
+        uint32_t text_off, text_len;   // lower‑case label in `texts`
+        uint64_t mask;       // characters present in the text
+    };
+    struct Match {
+        int idx;
+        int score;
+    };
+
+private:
+    std::vector<Candidate> candidates;   // arrival order, sorted by label once built
+    std::string texts;
+    std::vector<std::pair<std::string, std::vector<Match>>> levels;   // per typed prefix
+    bool built = false;
+
+    static uint64_t char_mask(const std::string& s) {
+        uint64_t m = 0;
+        for (unsigned char c : s) m |= 1ull << (c & 63);
+        return m;
+    }
+
+    static bool boundary(char c) {
+        return c == ' ' || c == '/' || c == '_' || c == '-' || c == '.';
+    }
+
+    // Score `q` as a subsequence of `t`; -1 if it is not one. The forward
+    // pass finds where the leftmost match ends, the backward pass the
+    // tightest window ending there, which is then scored.
+    static int score(const char* t, size_t n, const std::string& q) {
+        size_t ti = 0;
+        for (char qc : q) {
+            const void* hit = ti < n ? memchr(t + ti, qc, n - ti) : nullptr;
+            if (!hit) return -1;
+            ti = static_cast<const char*>(hit) - t + 1;
+        }
+
+        size_t end = ti, qi;
+        size_t start = end;
+        for (qi = q.size(); qi > 0;)
+            if (t[--start] == q[qi - 1]) --qi;
+
+        int s = 0, run = 0;
+        qi = 0;
+        for (size_t i = start; i < end; ++i) {
+            if (qi < q.size() && t[i] == q[qi]) {
+                s += 16 + 8 * std::min(run, 3);
+                if (i == 0 || boundary(t[i - 1])) s += 10;
+                ++run;
+                ++qi;
+            } else {
+                s -= 1;
+                run = 0;
+            }
         }
+        return s;
+    }
 
-        // Index image entries
-        entries.clear();
-        struct archive_entry* entry;
-        size_t idx = 0;
+    void index_text(Candidate& c) {
+        std::string text = c.label;
+        std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+        c.text_off = static_cast<uint32_t>(texts.size());
+        c.text_len = static_cast<uint32_t>(text.size());
+        c.mask = char_mask(text);
+        texts += text;
+    }
 
-        while (archive_read_next_header(archive_handle, &entry) == ARCHIVE_OK) {
-            std::string name = archive_entry_pathname(entry);
-            std::string ext = fs::path(name).extension().string();
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+public:
+    bool is_built() const { return built; }
+    size_t size() const { return candidates.size(); }
+    const Candidate& at(int idx) const { return candidates[idx]; }
+
+    void begin() {
+        candidates.clear();
+        texts.clear();
+        levels.clear();
+        built = false;
+    }
 
-            if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" ||
-                ext == ".gif" || ext == ".webp" || ext == ".bmp") {
-                PageEntry pg{ name, idx };
-                entries.push_back(pg);
+    // Append archives found by the walk. The library index is only read
+    // here, on the UI thread. Cached matches are dropped so the next
+    // query considers the newcomers too.
+    void add(const std::vector<FileEntry>& found, LibraryIndex& library) {
+        for (const FileEntry& fe : found) {
+            Candidate c;
+            c.path = fe.full_path;
+            c.label = fe.name.empty() ? fe.full_path : fe.name;
+            if (const LibraryEntry* e = library.find_path(c.path)) {
+                std::string meta = e->series;
+                if (!e->number.empty()) meta += " #" + e->number;
+                if (!e->title.empty()) meta += (meta.empty() ? "" : " – ") + e->title;
+                if (!meta.empty()) c.label += "  (" + meta + ")";
             }
-            archive_read_data_skip(archive_handle);
-            ++idx;
+            index_text(c);
+            candidates.push_back(std::move(c));
         }
+        if (!found.empty()) levels.clear();
+    }
 
-        // Natural sort
-        std::sort(entries.begin(), entries.end(),
-                  [](const PageEntry& a, const PageEntry& b) {
-                      return natural_sort_compare(a.name, b.name);
+    // Walk complete: sort once, so ties in score are broken by label order
+    void finish() {
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& a, const Candidate& b) {
+                      return natural_sort_compare(a.label, b.label);
                   });
+        texts.clear();
+        for (Candidate& c : candidates) index_text(c);
+        built = true;
+        levels.clear();
+    }
 
-        // Re‑open for sequential reading
-        archive_read_free(archive_handle);
-        archive_handle = archive_read_new();
-        archive_read_support_format_all(archive_handle);
-        archive_read_support_filter_all(archive_handle);
-        archive_read_open_filename(archive_handle, path.c_str(), 10240);
-        current_entry = -1;
+    // Best `limit` matches for `query`, highest score first
+    std::vector<Match> search(std::string query, size_t limit) {
+        std::transform(query.begin(), query.end(), query.begin(), ::tolower);
+        while (!levels.empty() && query.compare(0, levels.back().first.size(),
+                                                levels.back().first) != 0)
+            levels.pop_back();
+
+        if (levels.empty() || levels.back().first != query) {
+            uint64_t qmask = char_mask(query);
+            std::vector<Match> next;
+            auto consider = [&](int idx) {
+                const Candidate& c = candidates[idx];
+                if (qmask & ~c.mask) return;
+                int s = score(texts.data() + c.text_off, c.text_len, query);
+                if (s >= 0) next.push_back({ idx, s });
+            };
+            if (!levels.empty()) {
+                next.reserve(levels.back().second.size());
+                for (const Match& m : levels.back().second) consider(m.idx);
+            } else if (query.empty()) {
+                next.reserve(candidates.size());
+                for (size_t i = 0; i < candidates.size(); ++i)
+                    next.push_back({ static_cast<int>(i), 0 });
+            } else {
+                next.reserve(candidates.size());
+                for (size_t i = 0; i < candidates.size(); ++i) consider(static_cast<int>(i));
+            }
+            levels.emplace_back(query, std::move(next));
+        }
 
-        return !entries.empty();
+        std::vector<Match> top;
+        const std::vector<Match>& all = levels.back().second;
+        size_t n = std::min(limit, all.size());
+        top.resize(n);
+        std::partial_sort_copy(all.begin(), all.end(), top.begin(), top.end(),
+                               [](const Match& a, const Match& b) {
+                                   if (a.score != b.score) return a.score > b.score;
+                                   return a.idx < b.idx;
+                               });
+        return top;
     }
 
-    void close() {
-        if (archive_handle) {
-            archive_read_free(archive_handle);
-            archive_handle = nullptr;
-        }
-        entries.clear();
-        current_entry = -1;
+    size_t match_count() const { return levels.empty() ? 0 : levels.back().second.size(); }
+};
+
+// ------------------------------------------------------------------
+// Directory listing on a background thread. Entries are handed over in
+// batches through take(); fd() becomes readable whenever one is waiting.
+// A scan that is cancelled or replaced is abandoned rather than joined,
+// since a stalled readdir() on a network mount can take seconds to return
+// – the thread finishes on its own and drops its shared state.
+// start_tree() walks whole library roots instead: archives only, named
+// by their path below the root.
+// ------------------------------------------------------------------
+class DirScanner {
+public:
+    ~DirScanner() { cancel(); }
+
+    void start(const std::string& dir) { launch({ dir }, false); }
+    void start_tree(const std::vector<std::string>& roots) { launch(roots, true); }
+
+    void cancel() {
+        if (state) state->cancelled = true;
+        state.reset();
     }
 
-    std::vector<unsigned char> read_page(size_t page_idx) {
-        if (page_idx >= entries.size() || !archive_handle) return {};
+    int fd() const { return state ? state->wake[0] : -1; }
+    bool running() const { return state != nullptr; }
 
-        size_t target_idx = entries[page_idx].index_in_archive;
+    double elapsed_ms() const {
+        if (!state) return 0;
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - state->start).count();
+    }
 
-        if (current_entry > static_cast<int>(target_idx) || current_entry == -1) {
-            // Need to rewind
-            archive_read_free(archive_handle);
-            archive_handle = archive_read_new();
-            archive_read_support_format_all(archive_handle);
-            archive_read_support_filter_all(archive_handle);
-            archive_read_open_filename(archive_handle, archive_path.c_str(), 10240);
-            current_entry = -1;
-        }
+    // Move out what has arrived so far. Returns true once the listing is
+    // complete; `error` is then set if the directory could not be read.
+    bool take(std::vector<FileEntry>& batch, std::string& error) {
+        if (!state) return true;
+        char drain[64];
+        while (read(state->wake[0], drain, sizeof(drain)) > 0) {}
+
+        std::lock_guard<std::mutex> lock(state->m);
+        batch.swap(state->batch);
+        state->batch.clear();
+        if (!state->done) return false;
+        error = state->error;
+        state.reset();
+        return true;
+    }
 
-        struct archive_entry* entry;
-        while (archive_read_next_header(archive_handle, &entry) == ARCHIVE_OK) {
-            ++current_entry;
-            if (static_cast<size_t>(current_entry) == target_idx) {
-                size_t sz = archive_entry_size(entry);
-                std::vector<unsigned char> data(sz);
-                ssize_t got = archive_read_data(archive_handle, data.data(), sz);
-                if (got < 0) return {};
-                return data;
-            }
-            archive_read_data_skip(archive_handle);
+private:
+    struct State {
+        std::mutex m;
+        std::vector<FileEntry> batch;
+        std::string error;
+        bool done = false;
+        std::atomic<bool> cancelled{ false };
+        int wake[2] = { -1, -1 };
+        std::chrono::steady_clock::time_point start;
+        ~State() {
+            for (int fd : wake) if (fd >= 0) close(fd);
         }
-        return {};
+    };
+    std::shared_ptr<State> state;
+
+    void launch(std::vector<std::string> dirs, bool recursive) {
+        cancel();
+        auto st = std::make_shared<State>();
+        if (pipe(st->wake) != 0) return;
+        for (int fd : st->wake) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        st->start = std::chrono::steady_clock::now();
+        state = st;
+        std::thread(worker, st, std::move(dirs), recursive).detach();
     }
 
-    size_t page_count() const { return entries.size(); }
-    const std::vector<PageEntry>& get_entries() const { return entries; }
-};
+    static bool is_comic(const fs::path& p) {
+        std::string ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".cbz" || ext == ".cbr" || ext == ".zip";
+    }
 
-// ------------------------------------------------------------------
-// File‑system entry used for the directory browser
-// ------------------------------------------------------------------
-struct FileEntry {
-    std::string name;
-    std::string full_path;
-    bool is_directory;
+    static void worker(std::shared_ptr<State> st, std::vector<std::string> dirs,
+                       bool recursive) {
+        using clock = std::chrono::steady_clock;
+        std::vector<FileEntry> found;
+        auto last_flush = clock::now();
+        auto flush = [&](bool done, const std::string& error) {
+            {
+                std::lock_guard<std::mutex> lock(st->m);
+                for (FileEntry& fe : found) st->batch.push_back(std::move(fe));
+                st->done = done;
+                st->error = error;
+            }
+            found.clear();
+            last_flush = clock::now();
+            if (write(st->wake[1], "", 1) < 0) {}   // full pipe: already woken
+        };
+
+        auto emit = [&](FileEntry fe) {
+            found.push_back(std::move(fe));
+            if (found.size() >= 256 || clock::now() - last_flush > std::chrono::milliseconds(50))
+                flush(false, "");
+        };
+
+        std::error_code ec;
+        if (recursive) {
+            for (const std::string& root : dirs) {
+                std::error_code walk_ec;
+                fs::recursive_directory_iterator it(
+                    root, fs::directory_options::skip_permission_denied, walk_ec), end;
+                for (; !walk_ec && it != end && !st->cancelled; it.increment(walk_ec)) {
+                    std::error_code entry_ec;
+                    if (!it->is_regular_file(entry_ec) || !is_comic(it->path())) continue;
+                    FileEntry fe;
+                    fe.is_directory = false;
+                    fe.full_path = it->path().string();
+                    fe.name = it->path().lexically_relative(root).string();
+                    emit(std::move(fe));
+                }
+            }
+        } else {
+            fs::directory_iterator it(dirs[0], fs::directory_options::skip_permission_denied, ec), end;
+            for (; !ec && it != end && !st->cancelled; it.increment(ec)) {
+                std::error_code entry_ec;
+                FileEntry fe;
+                fe.is_directory = it->is_directory(entry_ec);
+                if (!fe.is_directory && !(it->is_regular_file(entry_ec) && is_comic(it->path())))
+                    continue;
+                fe.name = it->path().filename().string();
+                fe.full_path = it->path().string();
+                emit(std::move(fe));
+            }
+        }
+        if (!st->cancelled) flush(true, ec ? ec.message() : "");
+    }
 };
 
 // ------------------------------------------------------------------
@@ -368,10 +3895,83 @@ private:
     std::vector<FileEntry> entries;
     std::string current_dir;
     int selected_idx = 0;
+    int folder_cnt = 0, comic_cnt = 0;        // counted as the scan streams in
+    DirScanner scanner;
+    std::string scan_select;                  // entry to highlight once listed
+    std::string scan_error;                   // last listing failure, shown in the summary
+    bool scan_slow = false;                   // scan outlasted scan_slow_ms
+    static constexpr int scan_slow_ms = 300;
+    std::vector<std::string> library_roots;   // searched by '/'
+
+    // What the browser last put on screen, so a cursor move repaints only
+    // the lines that changed
+    struct ListView {
+        bool valid = false;
+        int top = 0;          // first visible entry
+        int sel = -1;         // highlighted entry
+        int rows = 0, cols = 0;
+    } list_view;
+
+    // Next issue, opened and partly decoded in the background near the end
+    struct NextComic {
+        FileEntry entry;
+        ArchiveReader reader;
+        bool ok = false;
+        std::map<int, std::vector<unsigned char>> raw;   // first pages
+        std::map<int, DecodedPage> decoded;
+        std::atomic<bool> cancel{ false };
+        std::thread worker;
+    };
+    std::unique_ptr<NextComic> next_comic;
+    std::map<int, DecodedPage> predecoded;   // handed over on roll‑over
+    std::map<int, DecodedPage> descreened;   // filtered pages (config.descreen)
+
+    // Fuzzy search mode
+    LibrarySearch search;
+    DirScanner search_scan;                   // walks library_roots for `search`
+    bool searching = false;
+    std::string search_query;
+    std::vector<LibrarySearch::Match> search_results;
+    int search_sel = 0;
+    double search_ms = 0;
 
     // Archive & caching
     ArchiveReader archive;
     std::map<int, std::vector<unsigned char>> page_cache;
+    std::map<int, std::pair<int, int>> page_dims_cache;    // page → w, h
+    DaemonClient daemon;
+    SharedPageCache shared_cache;
+    RenderCache render_cache;
+    PageIndexCache page_index;
+    size_t index_dims = 0;                   // page sizes the stored index knows
+    uint64_t archive_id = 0;                 // fingerprint keying caches & progress
+    std::string archive_path_open;           // path of the comic being read
+    bool in_idle_work = false;               // renders may go to disk now
+
+    // Renders made while drawing, written to the render cache once idle
+    struct UnsavedRender {
+        std::string name;
+        int w, h, channels;
+        std::vector<unsigned char> pixels;
+    };
+    std::deque<UnsavedRender> unsaved_renders;
+    static constexpr size_t max_unsaved_renders = 4;
+    static constexpr int cache_radius = 2;   // pages kept around the current one
+    KittyImageStore kitty_images;
+    std::vector<uint32_t> kitty_on_screen;   // ids placed by the last redraw
+    OutputWriter out{ STDOUT_FILENO };
+    bool idle_work = false;     // pre‑transmit once output drains
+    std::chrono::steady_clock::time_point quiet_since;   // view fully sent
+    static constexpr int refine_quiet_ms = 400;          // then refine previews
+    static constexpr double page_budget_s = 0.15;        // link time a page may take
+
+    // Cost of the current view: bytes queued and time until fully sent
+    struct PageStats {
+        size_t bytes = 0;
+        double ms = 0;
+        bool done = false;
+        std::chrono::steady_clock::time_point start;
+    } page_stats;
     int current_page = 0;
     bool viewing_comic = false;
     std::string current_comic_filename;
@@ -382,12 +3982,29 @@ private:
 
     // Config & progress
     Config config;
-    SimpleJSON progress;
-    std::string progress_path;
+    ProgressStore progress;
+    LibraryIndex library;
+
+    // Telemetry: timings of the view being sent, logged once it is out
+    TelemetryLog telemetry;
+    TelemetryLog::Archive tel_archive;
+    std::vector<PageEvent> view_events;
+    PageEvent* tel = nullptr;       // page being rendered for the current view
+    std::map<int, double> view_extract;   // pages read from the archive for it
+    struct {
+        int pages = 0;
+        size_t bytes = 0;
+        std::chrono::steady_clock::time_point start;
+    } tel_session;
+
+    static double ms_since(std::chrono::steady_clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
 
     // Terminal handling
     struct termios orig_termios;
-    bool need_redraw = false;
+    bool need_redraw = false;   // navigation seen, redraw once input settles
 
     // ------------------------------------------------------------------
     // Terminal raw‑mode helpers
@@ -409,11 +4026,36 @@ private:
 
     static void handle_sigwinch(int) { /* empty – just forces a redraw */ }
 
+    // ------------------------------------------------------------------
+    // Terminal detection: cached capabilities, else a one‑off probe. The
+    // cell size is asked for each time (fonts and zoom change).
+    // ------------------------------------------------------------------
+    void detect_terminal() {
+        bool cached = load_term_caps(term_caps);
+        TermCaps caps = term_caps;
+        if (probe_terminal(caps, !cached)) {
+            term_caps = caps;
+            if (!cached) save_term_caps(term_caps);
+        } else if (!cached) {
+            return;   // keep configured defaults
+        }
+        if (config.render_mode_auto)
+            config.render_mode = pick_render_mode(term_caps);
+    }
+
     // ------------------------------------------------------------------
     // Directory scanning
     // ------------------------------------------------------------------
-    void scan_directory() {
+    // Start listing current_dir in the background. The browser shows the
+    // parent entry at once and fills in the rest as batches arrive; `select`
+    // is highlighted when it shows up.
+    void scan_directory(const std::string& select = "") {
         entries.clear();
+        folder_cnt = comic_cnt = 0;
+        selected_idx = 0;
+        scan_select = select;
+        scan_error.clear();
+        scan_slow = false;
 
         // Parent entry (..) if not at filesystem root
         if (current_dir != "/" && current_dir.find('/') != std::string::npos) {
@@ -423,41 +4065,52 @@ private:
             parent.is_directory = true;
             entries.push_back(parent);
         }
+        list_view.valid = false;
+        list_view.top = 0;
+        scanner.start(current_dir);
+    }
+
+    // Merge a batch from the scanner into the sorted listing, keeping the
+    // highlighted entry where it is
+    void merge_scan() {
+        std::vector<FileEntry> batch;
+        bool done = scanner.take(batch, scan_error);
+        if (batch.empty() && !done) return;
 
+        auto by_name = [](const FileEntry& a, const FileEntry& b) {
+            return natural_sort_compare(a.name, b.name);
+        };
         std::vector<FileEntry> dirs, files;
-        try {
-            for (const auto& e : fs::directory_iterator(current_dir)) {
-                FileEntry fe;
-                fe.name = e.path().filename().string();
-                fe.full_path = e.path().string();
-                fe.is_directory = e.is_directory();
-
-                if (fe.is_directory) {
-                    dirs.push_back(fe);
-                } else if (e.is_regular_file()) {
-                    std::string ext = e.path().extension().string();
-                    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-                    if (ext == ".cbz" || ext == ".cbr" || ext == ".zip")
-                        files.push_back(fe);
-                }
+        for (FileEntry& fe : batch)
+            (fe.is_directory ? dirs : files).push_back(std::move(fe));
+        std::sort(dirs.begin(), dirs.end(), by_name);
+        std::sort(files.begin(), files.end(), by_name);
+
+        std::string keep = scan_select;
+        if (keep.empty() && selected_idx < static_cast<int>(entries.size()))
+            keep = entries[selected_idx].full_path;
+
+        auto first_dir = entries.begin() + (entries.size() - folder_cnt - comic_cnt);
+        auto first_file = first_dir + folder_cnt;
+        std::vector<FileEntry> merged(entries.begin(), first_dir);
+        merged.reserve(entries.size() + dirs.size() + files.size());
+        std::merge(std::make_move_iterator(first_dir), std::make_move_iterator(first_file),
+                   std::make_move_iterator(dirs.begin()), std::make_move_iterator(dirs.end()),
+                   std::back_inserter(merged), by_name);
+        std::merge(std::make_move_iterator(first_file), std::make_move_iterator(entries.end()),
+                   std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()),
+                   std::back_inserter(merged), by_name);
+        entries.swap(merged);
+        folder_cnt += static_cast<int>(dirs.size());
+        comic_cnt += static_cast<int>(files.size());
+
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].full_path == keep) {
+                selected_idx = static_cast<int>(i);
+                if (keep == scan_select) scan_select.clear();
+                break;
             }
-        } catch (...) {
-            // ignore permission errors etc.
-        }
-
-        std::sort(dirs.begin(), dirs.end(),
-                  [](const FileEntry& a, const FileEntry& b) {
-                      return natural_sort_compare(a.name, b.name);
-                  });
-        std::sort(files.begin(), files.end(),
-                  [](const FileEntry& a, const FileEntry& b) {
-                      return natural_sort_compare(a.name, b.name);
-                  });
-
-        entries.insert(entries.end(), dirs.begin(), dirs.end());
-        entries.insert(entries.end(), files.begin(), files.end());
-
-        if (selected_idx >= static_cast<int>(entries.size())) selected_idx = 0;
+        if (!viewing_comic && !searching) repaint_file_list();
     }
 
     // ------------------------------------------------------------------
@@ -467,28 +4120,259 @@ private:
         if (page_cache.count(page_idx))
             return page_cache[page_idx];
 
+        auto t0 = std::chrono::steady_clock::now();
         auto data = archive.read_page(page_idx);
+        if (telemetry.enabled()) view_extract[page_idx] += ms_since(t0);
         if (!data.empty()) {
-            // Simple LRU‑ish eviction (keep pages within ±2 of current)
+            // Simple LRU‑ish eviction (keep pages within ±cache_radius views
+            // of the current one, whichever page is being loaded)
+            int radius = cache_radius * (config.double_page ? 2 : 1);
             std::vector<int> to_remove;
             for (const auto& [idx, _] : page_cache)
-                if (std::abs(idx - page_idx) > 2) to_remove.push_back(idx);
+                if (std::abs(idx - current_page) > radius) to_remove.push_back(idx);
             for (int i : to_remove) page_cache.erase(i);
             page_cache[page_idx] = data;
         }
         return data;
     }
 
+    // ------------------------------------------------------------------
+    // Decoded pixels and dimensions of a page. With a daemon the pixels
+    // are its shared copy; otherwise the page is decoded here. With
+    // `descreen` the filtered copies of the pages on screen are kept as
+    // well (full-size bitmaps, so neighbours are not).
+    // ------------------------------------------------------------------
+    DecodedPage decode_page(int page_idx) {
+        if (config.descreen) {
+            auto it = descreened.find(page_idx);
+            if (it != descreened.end()) {
+                if (tel) tel->tier = "memory";
+                return it->second;
+            }
+        }
+        DecodedPage page = decode_source(page_idx);
+        if (!page.empty()) page_dims_cache[page_idx] = { page.w, page.h };
+        if (!config.descreen || page.empty()) return page;
+
+        // Filtered once per page; zoom, pan and redraws reuse the result
+        auto t0 = std::chrono::steady_clock::now();
+        page = descreen_page(page);
+        if (tel) tel->decode_ms += ms_since(t0);
+        int view_end = next_view(current_page);
+        for (auto it = descreened.begin(); it != descreened.end();)
+            it = (it->first < current_page || it->first >= view_end) ? descreened.erase(it)
+                                                                     : std::next(it);
+        if (page_idx >= current_page && page_idx < view_end) descreened[page_idx] = page;
+        return page;
+    }
+
+    DecodedPage decode_source(int page_idx) {
+        auto pre = predecoded.find(page_idx);
+        if (pre != predecoded.end()) {
+            if (tel) tel->tier = "prefetch";
+            return pre->second;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        DecodedPage page = archive.decode_page(page_idx);
+        if (!page.empty()) {
+            if (tel) {
+                tel->decode_ms += ms_since(t0);
+                tel->tier = "daemon";
+            }
+        } else {
+            auto raw = load_page(page_idx);
+            t0 = std::chrono::steady_clock::now();
+            page = decode_image(raw, 0);
+            if (tel) {
+                tel->decode_ms += ms_since(t0);
+                tel->tier = view_extract.count(page_idx) ? "archive" : "memory";
+            }
+        }
+        return page;
+    }
+
+    bool page_dims(int page_idx, int& w, int& h) {
+        auto it = page_dims_cache.find(page_idx);
+        if (it == page_dims_cache.end()) {
+            // Header only – also with a daemon, whose raw bytes are cheap
+            auto data = load_page(page_idx);
+            int ch;
+            if (data.empty() ||
+                !stbi_info_from_memory(data.data(), static_cast<int>(data.size()), &w, &h, &ch))
+                return false;
+            page_dims_cache[page_idx] = { w, h };
+            it = page_dims_cache.find(page_idx);
+        }
+        w = it->second.first;
+        h = it->second.second;
+        return true;
+    }
+
     // ------------------------------------------------------------------
     // Pre‑load the pages adjacent to the current one (for smoother paging)
     // ------------------------------------------------------------------
     void preload_adjacent() {
-        if (current_page + 1 < static_cast<int>(archive.page_count()))
+        if (current_page + 1 < static_cast<int>(archive.page_count()) &&
+            !rendered_on_disk(current_page + 1))
             load_page(current_page + 1);
-        if (current_page > 0)
+        if (current_page > 0 && !rendered_on_disk(current_page - 1))
             load_page(current_page - 1);
     }
 
+    // The page's unzoomed rendition (single or spread half) is in the
+    // render cache, e.g. after `tcreader warm` – no need to read it
+    bool rendered_on_disk(int page_idx) {
+        auto it = page_dims_cache.find(page_idx);
+        if (!render_cache.is_open() || it == page_dims_cache.end()) return false;
+        for (int width_px : { 0, get_term_size().pixel_width / 2 }) {
+            PageLayout lay = layout_page(it->second.first, it->second.second, 0, width_px, false);
+            for (int ch : { 1, 3 })
+                if (render_cache.on_disk(RenderCache::key(archive_id, page_idx, lay.new_w,
+                                                          lay.new_h, lay.crop_x, lay.crop_y,
+                                                          lay.crop_w, lay.crop_h, ch,
+                                                          config.render_style())))
+                    return true;
+        }
+        return false;
+    }
+
+    // ------------------------------------------------------------------
+    // The comic after the open one: the next issue of its series when the
+    // library index knows the series and number, else the next archive in
+    // the directory. The index only knows comics opened before, so an
+    // unindexed archive listed after this one that sorts before the
+    // index's pick (e.g. a new #3 between #2 and #5) wins. Empty
+    // full_path if there is none.
+    // ------------------------------------------------------------------
+    FileEntry find_next_comic() {
+        FileEntry next{ "", "", false };
+        const std::string path = archive_path_open;
+        if (const LibraryEntry* cur = library.find(archive_id)) {
+            if (!cur->series.empty() && !cur->number.empty()) {
+                double num = std::strtod(cur->number.c_str(), nullptr), best = 0;
+                for (const auto& [fp, e] : library.all()) {
+                    if (fp == archive_id || e.series != cur->series || e.number.empty())
+                        continue;
+                    double n = std::strtod(e.number.c_str(), nullptr);
+                    std::error_code ec;
+                    if (n > num && (next.full_path.empty() || n < best) &&
+                        fs::exists(e.path, ec)) {
+                        best = n;
+                        next.full_path = e.path;
+                    }
+                }
+            }
+        }
+        bool seen = false;
+        for (const FileEntry& fe : entries) {
+            if (seen && !fe.is_directory) {
+                if (next.full_path.empty()) {
+                    next.full_path = fe.full_path;
+                    break;
+                }
+                if (fe.full_path == next.full_path ||
+                    !natural_sort_compare(fe.name, fs::path(next.full_path).filename().string()))
+                    break;
+                if (!library.find_path(fe.full_path)) {
+                    next.full_path = fe.full_path;
+                    break;
+                }
+            }
+            if (fe.full_path == path) seen = true;
+        }
+        next.name = fs::path(next.full_path).filename().string();
+        return next;
+    }
+
+    // Near the end of a comic, open and index the next one and decode its
+    // first pages on a worker thread (local reading only – the daemon
+    // connection is not shared across threads)
+    void prefetch_next_comic() {
+        int count = static_cast<int>(archive.page_count());
+        if (next_view(current_page) < count - 2) return;
+        FileEntry next = find_next_comic();
+        if (next.full_path.empty() ||
+            (next_comic && next_comic->entry.full_path == next.full_path))
+            return;
+        cancel_next_comic();
+
+        next_comic = std::make_unique<NextComic>();
+        next_comic->entry = next;
+        NextComic* nc = next_comic.get();
+        nc->reader.set_cancel(&nc->cancel);
+        TermSize term = get_term_size();
+        int box_w = term.pixel_width, box_h = term.pixel_height - status_line_px;
+        // The worker gets copies of what it reads; the daemon connection
+        // and index cache stay with the main thread
+        bool use_index = !daemon.connected();
+        PageIndexCache index = page_index;
+        nc->worker = std::thread([this, nc, box_w, box_h, use_index, index] {
+            // A warmed archive opens from its page index, and pages already
+            // rendered to disk need no decode
+            uint64_t fp = archive_fingerprint(nc->entry.full_path);
+            PageIndex idx;
+            if (use_index && index.load(fp, idx)) {
+                nc->reader.open_indexed(nc->entry.full_path, idx);
+                nc->ok = true;
+            } else {
+                nc->ok = nc->reader.open_local(nc->entry.full_path);
+            }
+            for (int p = 0; nc->ok && !nc->cancel && p < std::min<int>(2, nc->reader.page_count());
+                 ++p) {
+                bool rendered = false;
+                for (int w : { box_w, box_w / 2 }) {
+                    int nw, nh;
+                    if (p >= static_cast<int>(idx.dims.size()) || idx.dims[p].first == 0) break;
+                    fit_page(idx.dims[p].first, idx.dims[p].second, w, box_h, 1.0f, nw, nh);
+                    for (int ch : { 1, 3 })
+                        rendered = rendered ||
+                                   render_cache.on_disk(RenderCache::key(fp, p, nw, nh, 0, 0,
+                                                                         nw, nh, ch,
+                                                                         config.render_style()));
+                }
+                if (rendered) continue;
+                nc->raw[p] = nc->reader.read_page(p);
+                nc->decoded[p] = decode_image(nc->raw[p], 0);
+            }
+        });
+    }
+
+    void cancel_next_comic() {
+        if (next_comic) next_comic->cancel = true;
+        if (next_comic && next_comic->worker.joinable()) next_comic->worker.join();
+        next_comic.reset();
+    }
+
+    // "next" on the last page: continue with the next comic, using the
+    // prefetched archive and pages when they are ready
+    bool roll_over() {
+        FileEntry next = find_next_comic();
+        if (next.full_path.empty()) return false;
+
+        std::unique_ptr<NextComic> ready;
+        if (next_comic && next_comic->entry.full_path == next.full_path) {
+            next_comic->worker.join();
+            ready = std::move(next_comic);
+        }
+        close_comic();
+
+        std::string dir = fs::path(next.full_path).parent_path().string();
+        if (dir != current_dir) {
+            current_dir = dir;
+            scan_directory(next.full_path);
+        }
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].full_path == next.full_path) selected_idx = static_cast<int>(i);
+
+        if (ready && ready->ok) {
+            archive.swap(ready->reader);
+            page_cache = std::move(ready->raw);
+            predecoded = std::move(ready->decoded);
+        }
+        open_comic(next, false);
+        return true;
+    }
+
     // ------------------------------------------------------------------
     // Rendering helpers
     // ------------------------------------------------------------------
@@ -522,9 +4406,8 @@ private:
         int target_h = std::min(term.rows - 4, 40);
 
         std::vector<unsigned char> resized(target_w * target_h);
-        stbir_resize_uint8_linear(pixels, w, h, 0,
-                                  resized.data(), target_w, target_h, 0,
-                                  STBIR_1CHANNEL);
+        resize_pixels(pixels, w, h, resized.data(), target_w, target_h, 1,
+                      config.resize_filter);
 
         const char* charset =
             " .'`^\",:;Il!i><~+_-?][}{1)(|/tfjrxnuvczXYUJCLQ0OZmwqpdbkhao*#MW&8%B@$";
@@ -542,114 +4425,440 @@ private:
         stbi_image_free(pixels);
     }
 
-    void render_kitty(const std::vector<unsigned char>& img_data,
-                      int col_offset = 0, int width_px = 0) {
-        int w, h, ch;
-        unsigned char* pixels = stbi_load_from_memory(
-            img_data.data(), static_cast<int>(img_data.size()), &w, &h, &ch, 3);
-        if (!pixels) {
-            std::cout << "[Failed to decode: " << stbi_failure_reason()
-                      << "]\n";
-            return;
-        }
-
+    // ------------------------------------------------------------------
+    // Page geometry shared by the pixel backends (scale, pan, crop, cells)
+    // ------------------------------------------------------------------
+    struct PageLayout {
+        int target_w, target_h;      // pixel box available for the page
+        int new_w, new_h;            // scaled image size (before crop)
+        int crop_x, crop_y, crop_w, crop_h;
+        int cols, rows;              // character cells occupied
+        int col, row;                // 1‑based cursor position
+    };
+
+    // commit_pan=false lays out a page that is not being shown (prefetch)
+    // without clamping the live pan state to it.
+    PageLayout layout_page(int w, int h, int col_offset, int width_px,
+                           bool commit_pan = true) {
         TermSize term = get_term_size();
-        int target_w = width_px > 0 ? width_px : term.pixel_width;
-        int target_h = term.pixel_height - 100;  // leave room for status line
+        PageLayout lay;
+        lay.target_w = width_px > 0 ? width_px : term.pixel_width;
+        lay.target_h = term.pixel_height - status_line_px;
 
         // Apply zoom (scale uniformly)
-        float scale = std::min(static_cast<float>(target_w) / w,
-                              static_cast<float>(target_h) / h) *
-                      zoom_level;
-        int new_w = static_cast<int>(w * scale);
-        int new_h = static_cast<int>(h * scale);
+        fit_page(w, h, lay.target_w, lay.target_h, zoom_level, lay.new_w, lay.new_h);
 
         // Clamp pan so we never scroll past the image edges
-        int max_pan_x = std::max(0, new_w - target_w);
-        int max_pan_y = std::max(0, new_h - target_h);
-        pan_x = std::clamp(pan_x, -max_pan_x, 0);
-        pan_y = std::clamp(pan_y, -max_pan_y, 0);
+        int max_pan_x = std::max(0, lay.new_w - lay.target_w);
+        int max_pan_y = std::max(0, lay.new_h - lay.target_h);
+        int px = std::clamp(pan_x, -max_pan_x, 0);
+        int py = std::clamp(pan_y, -max_pan_y, 0);
+        if (commit_pan) {
+            pan_x = px;
+            pan_y = py;
+        }
+
+        // Crop to the visible region (taking pan into account)
+        lay.crop_x = std::abs(px);
+        lay.crop_y = std::abs(py);
+        lay.crop_w = std::min(lay.new_w - lay.crop_x, lay.target_w);
+        lay.crop_h = std::min(lay.new_h - lay.crop_y, lay.target_h);
+
+        // Determine how many character cells the image occupies
+        int char_w = term.pixel_width / term.cols;
+        int char_h = term.pixel_height / term.rows;
+        lay.cols = (lay.crop_w + char_w - 1) / char_w;
+        lay.rows = (lay.crop_h + char_h - 1) / char_h;
+
+        // Center the image (unless an explicit column offset was given)
+        int col_center = col_offset + (lay.target_w / char_w - lay.cols) / 2;
+        int row_center = (lay.target_h / char_h - lay.rows) / 2 + 1;
+        lay.col = std::max(0, col_center) + 1;
+        lay.row = std::max(1, row_center);
+        return lay;
+    }
+
+    bool needs_crop(const PageLayout& lay) const {
+        return lay.crop_w != lay.new_w || lay.crop_h != lay.new_h;
+    }
+
+    // Page scaled to the layout size and cut to the visible part. A
+    // rendition from an earlier session comes off disk; the scaled page
+    // comes from the shared cache when another reader (or an earlier
+    // visit) already produced it. Empty if the page won't decode.
+    // `channels` comes back as 1 for a grayscale page, which stays one
+    // channel through scaling and both caches, else 3.
+    std::vector<unsigned char> resize_and_crop(int page_idx, const PageLayout& lay,
+                                               int& channels) {
+        std::vector<unsigned char> cropped;
+        for (int ch : { 1, 3 }) {
+            std::string name = RenderCache::key(archive_id, page_idx, lay.new_w, lay.new_h,
+                                                lay.crop_x, lay.crop_y, lay.crop_w,
+                                                lay.crop_h, ch, config.render_style());
+            if (render_cache.load(name, lay.crop_w, lay.crop_h, cropped, ch)) {
+                if (tel) tel->tier = "disk";
+                channels = ch;
+                return cropped;
+            }
+        }
+        cropped = scale_and_crop(page_idx, lay, channels);
+        if (!render_cache.is_open() || cropped.empty()) return cropped;
+
+        // Prefetch and refinement run while idle – store their work then.
+        // A page rendered for display is written once the view is out.
+        std::string name = RenderCache::key(archive_id, page_idx, lay.new_w, lay.new_h,
+                                            lay.crop_x, lay.crop_y, lay.crop_w, lay.crop_h,
+                                            channels, config.render_style());
+        if (in_idle_work) {
+            render_cache.store(name, lay.crop_w, lay.crop_h, cropped, channels);
+        } else {
+            if (unsaved_renders.size() >= max_unsaved_renders) unsaved_renders.pop_front();
+            unsaved_renders.push_back({ name, lay.crop_w, lay.crop_h, channels, cropped });
+        }
+        return cropped;
+    }
 
-        // Resize
-        std::vector<unsigned char> resized(new_w * new_h * 3);
-        stbir_resize_uint8_linear(pixels, w, h, 0,
-                                  resized.data(), new_w, new_h, 0,
-                                  STBIR_RGB);
+    std::vector<unsigned char> scale_and_crop(int page_idx, const PageLayout& lay,
+                                              int& channels) {
+        std::vector<unsigned char> resized;
+        bool shared = false;
+        for (int ch : { 1, 3 }) {
+            uint64_t key = SharedPageCache::make_key(archive_id, page_idx, lay.new_w, lay.new_h,
+                                                     ch, config.render_style());
+            if (shared_cache.get(key, lay.new_w, lay.new_h, resized, ch)) {
+                if (tel) tel->tier = "shm";
+                channels = ch;
+                shared = true;
+                break;
+            }
+        }
+        if (!shared) {
+            DecodedPage page = decode_page(page_idx);
+            if (page.empty()) return {};
+            channels = page.channels;
+            auto t0 = std::chrono::steady_clock::now();
+            resized.resize(static_cast<size_t>(lay.new_w) * lay.new_h * channels);
+            resize_pixels(page.pixels.get(), page.w, page.h, resized.data(),
+                          lay.new_w, lay.new_h, channels, config.resize_filter);
+            if (tel) tel->resize_ms += ms_since(t0);
+            shared_cache.put(SharedPageCache::make_key(archive_id, page_idx, lay.new_w,
+                                                       lay.new_h, channels,
+                                                       config.render_style()),
+                             lay.new_w, lay.new_h, resized, channels);
+        }
+        if (!needs_crop(lay)) return resized;
+
+        size_t row = static_cast<size_t>(lay.crop_w) * channels;
+        std::vector<unsigned char> cropped(row * lay.crop_h);
+        for (int y = 0; y < lay.crop_h; ++y) {
+            const unsigned char* src =
+                &resized[((lay.crop_y + y) * static_cast<size_t>(lay.new_w) + lay.crop_x) * channels];
+            memcpy(&cropped[y * row], src, row);
+        }
+        return cropped;
+    }
+
+    // Identifies one rendition of a page (size and visible crop)
+    static std::string kitty_key(int page_idx, const PageLayout& lay) {
+        std::ostringstream key;
+        key << page_idx << ':' << lay.new_w << 'x' << lay.new_h << '+'
+            << lay.crop_x << ',' << lay.crop_y << '/' << lay.crop_w << 'x' << lay.crop_h;
+        return key.str();
+    }
+
+    // Pick the resolution factor for a transmission of `bytes`. In auto
+    // mode a page that would take longer than page_budget_s on the
+    // measured link goes out smaller first and is refined to full size
+    // once no key has come for refine_quiet_ms.
+    float transmit_scale(size_t bytes) const {
+        switch (config.quality) {
+            case Quality::FULL: return 1.0f;
+            case Quality::LOW:  return 0.5f;
+            case Quality::AUTO: break;
+        }
+        double t = out.throughput.seconds_for(bytes);
+        if (t <= page_budget_s) return 1.0f;
+        return std::clamp(static_cast<float>(std::sqrt(page_budget_s / t)), 0.25f, 0.75f);
+    }
+
+    // Whether an RGB rendition of `bytes` should be sent palette‑indexed:
+    // always when `palette` is a colour count, or with `palette = auto`
+    // when the measured link needs longer than the page budget for it
+    bool use_palette(size_t bytes) const {
+        if (!config.palette_colors) return false;
+        if (!config.palette_auto) return true;
+        return out.throughput.seconds_for(bytes * 4 / 3) > page_budget_s;
+    }
+
+    std::vector<unsigned char> encode_indexed(const unsigned char* rgb, int w, int h) {
+        std::vector<unsigned char> indices;
+        std::vector<unsigned char> palette =
+            quantize_rgb(rgb, w, h, config.palette_colors, config.palette_dither, indices);
+        return encode_png_indexed(indices.data(), w, h, palette.data(),
+                                  static_cast<int>(palette.size() / 3));
+    }
+
+    // Decode, scale and send one page rendition (a known key keeps its id).
+    // action "T" transmits and places at the cursor, "t" only stores it.
+    // refine=true ignores the quality policy and sends full resolution.
+    uint32_t kitty_transmit(int page_idx, const PageLayout& lay,
+                            const std::string& key, char action,
+                            bool refine = false) {
+        int channels = 3;
+        std::vector<unsigned char> cropped = resize_and_crop(page_idx, lay, channels);
+        if (cropped.empty()) {
+            if (action == 'T')
+                out.push(strfmt("[Failed to decode: %s]\n", stbi_failure_reason()));
+            return 0;
+        }
+
+        // Reduced preview on slow links: Kitty scales it up to c×r cells.
+        // An indexed page needs a third of the bytes before deflate.
+        int send_w = lay.crop_w, send_h = lay.crop_h;
+        bool indexed = channels == 3 && use_palette(cropped.size());
+        size_t estimate = indexed ? cropped.size() / 3 : cropped.size();
+        float scale = refine ? 1.0f : transmit_scale(estimate * 4 / 3);
+        if (scale < 1.0f) {
+            send_w = std::max(1, static_cast<int>(lay.crop_w * scale));
+            send_h = std::max(1, static_cast<int>(lay.crop_h * scale));
+            std::vector<unsigned char> small(static_cast<size_t>(send_w) * send_h * channels);
+            resize_pixels(cropped.data(), lay.crop_w, lay.crop_h, small.data(),
+                          send_w, send_h, channels, config.resize_filter);
+            cropped.swap(small);
+        }
+
+        // Kitty has no 8‑bit gray format: a grayscale page goes out as a
+        // gray PNG, a third of the raw RGB before deflate even starts
+        std::string format = strfmt("f=24,s=%d,v=%d", send_w, send_h);
+        if (channels == 1) {
+            cropped = encode_png(cropped.data(), send_w, send_h, 1);
+            format = "f=100";
+        } else if (indexed) {
+            cropped = encode_indexed(cropped.data(), send_w, send_h);
+            format = "f=100";
+        }
+
+        // Encode to base64 for the Kitty graphics protocol
+        std::string b64 = base64_encode(cropped.data(),
+                                        static_cast<size_t>(cropped.size()));
+        uint32_t id = kitty_images.put(key, page_idx, static_cast<size_t>(send_w) * send_h * 3,
+                                       scale < 1.0f);
+
+        // Queue the image in chunks (Kitty protocol). The id keeps it stored
+        // terminal‑side for reuse; q=2 suppresses the replies ids trigger.
+        const size_t chunk_sz = 4096;
+        size_t offset = 0;
+        while (offset < b64.size()) {
+            size_t remain = b64.size() - offset;
+            size_t this_chunk = std::min(chunk_sz, remain);
+            bool last = (offset + this_chunk >= b64.size());
+
+            std::string chunk;
+            if (offset == 0 && action == 'T') {
+                // First chunk – include dimensions & placement
+                chunk = strfmt("\033_G%s,a=T,i=%u,q=2,c=%d,r=%d,m=%d;",
+                               format.c_str(), id, lay.cols, lay.rows, last ? 0 : 1);
+            } else if (offset == 0) {
+                // First chunk – dimensions only, no placement
+                chunk = strfmt("\033_G%s,a=t,i=%u,q=2,m=%d;",
+                               format.c_str(), id, last ? 0 : 1);
+            } else {
+                // Subsequent chunks
+                chunk = strfmt("\033_Gm=%d;", last ? 0 : 1);
+            }
+
+            chunk.append(b64, offset, this_chunk);
+            chunk += "\033\\";
+            out.push_image(std::move(chunk), id, last);
+            offset += this_chunk;
+        }
+
+        if (action == 'T' && !page_stats.done) page_stats.bytes += b64.size();
+        if (action == 'T' && tel) tel->bytes += b64.size();
+        return id;
+    }
+
+    void render_kitty(int page_idx, int col_offset = 0, int width_px = 0) {
+        int w, h;
+        if (!page_dims(page_idx, w, h)) {
+            out.push(strfmt("[Failed to decode: %s]\n", stbi_failure_reason()));
+            return;
+        }
+
+        PageLayout lay = layout_page(w, h, col_offset, width_px);
+        std::string key = kitty_key(page_idx, lay);
+
+        // Position cursor
+        out.push(strfmt("\033[%d;%dH", lay.row, lay.col));
+
+        // Already resident in the terminal (revisited or pre‑transmitted)
+        // → a placement is all a page turn costs
+        uint32_t id;
+        if (const KittyImage* img = kitty_images.find(key)) {
+            id = img->id;
+            out.push(strfmt("\033_Ga=p,i=%u,c=%d,r=%d,q=2\033\\", id, lay.cols, lay.rows));
+            if (tel) tel->tier = "terminal";
+        } else {
+            id = kitty_transmit(page_idx, lay, key, 'T');
+        }
+        if (id) kitty_on_screen.push_back(id);
+    }
+
+    // ------------------------------------------------------------------
+    // Idle‑time pre‑transmission: store the pages the next and previous
+    // page turns will show (a=t, no placement) so the turn itself only
+    // needs an a=p. Stops as soon as a key is waiting.
+    // ------------------------------------------------------------------
+    static bool input_pending(int wait_ms = 0) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        return poll(&pfd, 1, wait_ms) > 0;
+    }
+
+    void kitty_pretransmit(int page_idx, int col_offset, int width_px) {
+        int w, h;
+        if (page_idx < 0 || page_idx >= static_cast<int>(archive.page_count()) ||
+            !page_dims(page_idx, w, h))
+            return;
+
+        PageLayout lay = layout_page(w, h, col_offset, width_px, false);
+        std::string key = kitty_key(page_idx, lay);
+        if (!kitty_images.find(key))
+            kitty_transmit(page_idx, lay, key, 't');
+    }
+
+    // Replace reduced previews of the pages on screen with full quality
+    // (auto mode only – "low" keeps the previews on purpose)
+    bool refine_due() {
+        if (config.quality != Quality::AUTO || config.render_mode != RenderMode::KITTY)
+            return false;
+        for (uint32_t id : kitty_on_screen)
+            if (kitty_images.is_reduced(id)) return true;
+        return false;
+    }
+
+    void refine_on_screen() {
+        if (config.quality != Quality::AUTO) return;
+        for (const ViewSlot& slot : view_slots(current_page)) {
+            if (input_pending()) return;
+            int w, h;
+            if (!page_dims(slot.page, w, h)) continue;
+
+            PageLayout lay = layout_page(w, h, slot.col_offset, slot.width_px);
+            std::string key = kitty_key(slot.page, lay);
+            const KittyImage* img = kitty_images.find(key);
+            if (!img || !img->reduced) continue;
+
+            // Re‑send under the same id: Kitty swaps in the new data and
+            // placement only once the last chunk arrives, so the preview
+            // stays up for the whole transfer
+            out.push(strfmt("\033[%d;%dH", lay.row, lay.col));
+            kitty_transmit(slot.page, lay, key, 'T', true);
+        }
+    }
 
-        // Crop to the visible region (taking pan into account)
-        int crop_x = std::abs(pan_x);
-        int crop_y = std::abs(pan_y);
-        int crop_w = std::min(new_w - crop_x, target_w);
-        int crop_h = std::min(new_h - crop_y, target_h);
+    // Resident (or in‑flight) Kitty images the current view will place
+    std::vector<uint32_t> kitty_ids_for_view() {
+        std::vector<uint32_t> ids;
+        if (config.render_mode != RenderMode::KITTY) return ids;
+        for (const ViewSlot& slot : view_slots(current_page)) {
+            int w, h;
+            if (!page_dims(slot.page, w, h)) continue;
+            PageLayout lay = layout_page(w, h, slot.col_offset, slot.width_px, false);
+            if (const KittyImage* img = kitty_images.find(kitty_key(slot.page, lay)))
+                ids.push_back(img->id);
+        }
+        return ids;
+    }
 
-        std::vector<unsigned char> cropped(crop_w * crop_h * 3);
-        for (int y = 0; y < crop_h; ++y) {
-            for (int x = 0; x < crop_w; ++x) {
-                int src_idx = ((crop_y + y) * new_w + (crop_x + x)) * 3;
-                int dst_idx = (y * crop_w + x) * 3;
-                cropped[dst_idx + 0] = resized[src_idx + 0];
-                cropped[dst_idx + 1] = resized[src_idx + 1];
-                cropped[dst_idx + 2] = resized[src_idx + 2];
+    void pretransmit_neighbours() {
+        for (int first : { next_view(current_page), prev_view(current_page) }) {
+            if (first == current_page) continue;
+            for (const ViewSlot& slot : view_slots(first)) {
+                if (input_pending()) return;
+                kitty_pretransmit(slot.page, slot.col_offset, slot.width_px);
             }
         }
+    }
 
-        // Encode to base64 for the Kitty graphics protocol
-        std::string b64 = base64_encode(cropped.data(),
-                                        static_cast<size_t>(cropped.size()));
-
-        // Determine how many character cells the image occupies
-        int char_w = term.pixel_width / term.cols;
-        int char_h = term.pixel_height / term.rows;
-        int cols_needed = (crop_w + char_w - 1) / char_w;
-        int rows_needed = (crop_h + char_h - 1) / char_h;
+    // Free terminal‑side images (a=d,d=I releases the pixel data too)
+    void kitty_delete(const std::vector<uint32_t>& ids) {
+        for (uint32_t id : ids)
+            out.push(strfmt("\033_Ga=d,d=I,i=%u,q=2\033\\", id));
+    }
 
-        // Center the image (unless an explicit column offset was given)
-        int col_center = col_offset +
-                         (target_w / char_w - cols_needed) / 2;
-        int row_center = (target_h / char_h - rows_needed) / 2 + 1;
-        col_center = std::max(0, col_center);
-        row_center = std::max(1, row_center);
+    void kitty_evict() {
+        kitty_images.budget_bytes = config.kitty_memory_mb << 20;
+        int radius = cache_radius * (config.double_page ? 2 : 1);
+        kitty_delete(kitty_images.evict(current_page, radius, kitty_on_screen));
+    }
 
-        // Position cursor
-        printf("\033[%d;%dH", row_center, col_center + 1);
-        fflush(stdout);
+    // ------------------------------------------------------------------
+    // iTerm2 inline images (OSC 1337) – also understood by WezTerm.
+    // The archive bytes are passed through untouched whenever the whole
+    // page is visible; only zoom/pan crops force a decode + PNG re‑encode.
+    // ------------------------------------------------------------------
+    void render_iterm2(int page_idx, const std::vector<unsigned char>& img_data,
+                       int col_offset = 0, int width_px = 0) {
+        int w, h, ch;
+        if (!stbi_info_from_memory(img_data.data(),
+                                   static_cast<int>(img_data.size()),
+                                   &w, &h, &ch)) {
+            out.push(strfmt("[Failed to decode: %s]\n", stbi_failure_reason()));
+            return;
+        }
 
-        // Send the image in chunks (Kitty protocol)
-        const size_t chunk_sz = 4096;
-        size_t offset = 0;
-        while (offset < b64.size()) {
-            size_t remain = b64.size() - offset;
-            size_t this_chunk = std::min(chunk_sz, remain);
-            bool last = (offset + this_chunk >= b64.size());
+        PageLayout lay = layout_page(w, h, col_offset, width_px);
 
-            if (offset == 0) {
-                // First chunk – include dimensions & placement
-                printf("\033_Gf=24,a=T,s=%d,v=%d,c=%d,r=%d,m=%d;",
-                       crop_w, crop_h, cols_needed, rows_needed,
-                       last ? 0 : 1);
-            } else {
-                // Subsequent chunks
-                printf("\033_Gm=%d;", last ? 0 : 1);
+        std::vector<unsigned char> encoded;
+        const std::vector<unsigned char>* payload = &img_data;
+        if (needs_crop(lay)) {
+            int channels = 3;
+            std::vector<unsigned char> cropped = resize_and_crop(page_idx, lay, channels);
+            if (cropped.empty()) {
+                out.push(strfmt("[Failed to decode: %s]\n", stbi_failure_reason()));
+                return;
             }
-
-            fwrite(b64.data() + offset, 1, this_chunk, stdout);
-            printf("\033\\");
-            fflush(stdout);
-            offset += this_chunk;
+            if (channels == 3 && use_palette(cropped.size()))
+                encoded = encode_indexed(cropped.data(), lay.crop_w, lay.crop_h);
+            else
+                encoded = encode_png(cropped.data(), lay.crop_w, lay.crop_h, channels);
+            payload = &encoded;
         }
 
-        stbi_image_free(pixels);
+        std::string b64 = base64_encode(payload->data(), payload->size());
+
+        // One OSC sequence – it cannot be split, but can still be dropped
+        // as a whole if the user moves on before it starts
+        out.push(strfmt("\033[%d;%dH", lay.row, lay.col));
+        std::string seq = strfmt("\033]1337;File=inline=1;size=%zu;width=%d;height=%d;"
+                                 "preserveAspectRatio=1:",
+                                 payload->size(), lay.cols, lay.rows);
+        seq += b64;
+        seq += "\a";
+        if (!page_stats.done) page_stats.bytes += seq.size();
+        if (tel) tel->bytes += seq.size();
+        out.push_image(std::move(seq));
     }
 
     // ------------------------------------------------------------------
     // Dispatch to the selected renderer
     // ------------------------------------------------------------------
-    void display_image(const std::vector<unsigned char>& img_data,
-                       int x_offset = 0, int width = 0) {
+    void display_image(int page_idx, int x_offset = 0, int width = 0) {
+        // Kitty works from decoded pixels (or a resident image) only
+        if (config.render_mode == RenderMode::KITTY) {
+            render_kitty(page_idx, x_offset, width);
+            return;
+        }
+
+        auto img_data = load_page(page_idx);
         if (img_data.empty()) {
-            std::cout << "[Empty image data]\n";
+            out.push("[Empty image data]\n");
             return;
         }
+        if (tel) tel->tier = view_extract.count(page_idx) ? "archive" : "memory";
+        int w, h, ch;   // the bytes are here anyway: remember the page's shape
+        if (stbi_info_from_memory(img_data.data(), static_cast<int>(img_data.size()), &w, &h, &ch))
+            page_dims_cache[page_idx] = { w, h };
 
         TermSize term = get_term_size();
         int target_cols = width > 0 ? width / (term.pixel_width / term.cols) : term.cols;
@@ -657,12 +4866,16 @@ private:
 
         switch (config.render_mode) {
             case RenderMode::KITTY:
-                render_kitty(img_data, x_offset, width);
+                break;
+            case RenderMode::ITERM2:
+                render_iterm2(page_idx, img_data, x_offset, width);
                 break;
             case RenderMode::TIMG:
+                out.drain();   // timg and ASCII write to the tty directly
                 render_with_timg(img_data, "/tmp/tcreader_page_" + std::to_string(x_offset) + ".tmp", target_cols, target_rows);
                 break;
             case RenderMode::ASCII:
+                out.drain();
                 render_ascii(img_data);
                 break;
         }
@@ -671,101 +4884,538 @@ private:
     // ------------------------------------------------------------------
     // UI: file‑list view
     // ------------------------------------------------------------------
+    int list_first_row() const { return config.show_help ? 4 : 3; }
+    int list_rows() { return std::max(1, get_term_size().rows - (config.show_help ? 6 : 5)); }
+
+    // Keep the selection inside the visible window, scrolling minimally
+    int list_top_for(int sel, int top, int rows) {
+        if (sel < top) return sel;
+        if (sel >= top + rows) return sel - rows + 1;
+        return std::clamp(top, 0, std::max(0, static_cast<int>(entries.size()) - rows));
+    }
+
+    void draw_list_line(std::ostream& os, int i) {
+        os << "\033[" << list_first_row() + (i - list_view.top) << ";1H\033[2K";
+        if (i < 0 || i >= static_cast<int>(entries.size())) return;
+        const FileEntry& fe = entries[i];
+        std::string prefix = fe.is_directory ? "📁 " : "  ";
+        if (i == selected_idx)
+            os << "\033[7m► " << prefix << fe.name << "\033[0m";
+        else
+            os << "  " << prefix << fe.name;
+    }
+
     void draw_file_list() {
         clear_screen();
         std::cout << "\033[1;1H";
         std::cout << "tcreader - " << current_dir << "\n";
 
         if (config.show_help) {
-            std::cout << "Enter=open | r=refresh | g/G=first/last | j/k=down/up | ?=help | q=quit\n";
+            std::cout << "Enter=open | /=search | r=refresh | g/G=first/last | j/k=down/up | PgUp/PgDn=page | ?=help | q=quit\n";
         }
-        std::cout << "\n";
 
         TermSize term = get_term_size();
-        int lines_available = term.rows - (config.show_help ? 6 : 5);
-        int start = std::max(0, selected_idx - lines_available / 2);
-        int end   = std::min(static_cast<int>(entries.size()),
-                             start + lines_available);
+        int rows = list_rows();
+        list_view.top = list_top_for(selected_idx, list_view.top, rows);
+        int end = std::min(static_cast<int>(entries.size()), list_view.top + rows);
 
-        for (int i = start; i < end; ++i) {
-            const FileEntry& fe = entries[i];
-            std::string prefix = fe.is_directory ? "📁 " : "  ";
+        std::ostringstream buf;
+        for (int i = list_view.top; i < end; ++i) draw_list_line(buf, i);
 
-            if (i == selected_idx) {
-                std::cout << "\033[7m► " << prefix << fe.name << "\033[0m\n";
-            } else {
-                std::cout << "  " << prefix << fe.name << "\n";
+        draw_list_summary(buf);
+        std::cout << buf.str() << std::flush;
+
+        list_view.valid = true;
+        list_view.sel = selected_idx;
+        list_view.rows = term.rows;
+        list_view.cols = term.cols;
+    }
+
+    // Counts below the list, with the state of a scan still in progress
+    void draw_list_summary(std::ostream& os) {
+        int first = list_first_row(), rows = list_rows();
+        int shown = std::clamp(static_cast<int>(entries.size()) - list_view.top, 0, rows);
+        os << "\033[" << first + rows << ";1H\033[2K\033[" << first + rows + 1 << ";1H\033[2K";
+        os << "\033[" << first + shown + 1 << ";1H"
+           << folder_cnt << " folders, " << comic_cnt << " comics";
+        if (scanner.running() && scan_slow) os << " | scanning…";
+        if (!scan_error.empty()) os << " | can't read directory: " << scan_error;
+    }
+
+    // Listing changed under the cursor: repaint the window and summary in place
+    void repaint_file_list() {
+        TermSize term = get_term_size();
+        if (!list_view.valid || term.rows != list_view.rows || term.cols != list_view.cols) {
+            draw_file_list();
+            return;
+        }
+        int rows = list_rows();
+        list_view.top = list_top_for(selected_idx, list_view.top, rows);
+        std::ostringstream buf;
+        for (int i = list_view.top; i < list_view.top + rows; ++i) draw_list_line(buf, i);
+        draw_list_summary(buf);
+        list_view.sel = selected_idx;
+        std::cout << buf.str() << std::flush;
+    }
+
+    // Cursor moved: repaint the old and new highlighted lines, shifting the
+    // list with a scroll region when the window moves by less than a page
+    void update_file_list() {
+        TermSize term = get_term_size();
+        if (!list_view.valid || term.rows != list_view.rows || term.cols != list_view.cols) {
+            draw_file_list();
+            return;
+        }
+        int rows = list_rows();
+        int new_top = list_top_for(selected_idx, list_view.top, rows);
+        int shift = new_top - list_view.top;
+        std::ostringstream buf;
+
+        if (std::abs(shift) >= rows) {
+            list_view.top = new_top;
+            int end = std::min(static_cast<int>(entries.size()), new_top + rows);
+            for (int i = new_top; i < end; ++i) draw_list_line(buf, i);
+        } else {
+            if (shift != 0) {
+                int first = list_first_row();
+                buf << "\033[" << first << ";" << first + rows - 1 << "r";
+                buf << (shift > 0 ? strfmt("\033[%dS", shift) : strfmt("\033[%dT", -shift));
+                buf << "\033[r";
+                list_view.top = new_top;
+                // Lines scrolled into view
+                int from = shift > 0 ? new_top + rows - shift : new_top;
+                for (int i = from; i < from + std::abs(shift); ++i)
+                    if (i != selected_idx) draw_list_line(buf, i);
             }
+            if (list_view.sel >= new_top && list_view.sel < new_top + rows)
+                draw_list_line(buf, list_view.sel);
+            draw_list_line(buf, selected_idx);
+        }
+        list_view.sel = selected_idx;
+        std::cout << buf.str() << std::flush;
+    }
+
+    // ------------------------------------------------------------------
+    // UI: fuzzy search across the library ('/')
+    // ------------------------------------------------------------------
+    int search_rows() {
+        return std::max(1, get_term_size().rows - (config.show_help ? 6 : 5));
+    }
+
+    // Re‑run the query; `keep_sel` when the list grew under the cursor
+    // rather than the query changing
+    void update_search(bool keep_sel = false) {
+        if (!search.is_built() && !search_scan.running()) {
+            search.begin();
+            search_scan.start_tree(library_roots);
+            if (!search_scan.running()) search.finish();
         }
+        auto t0 = std::chrono::steady_clock::now();
+        search_results = search.search(search_query, search_rows());
+        search_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        int last = std::max(0, static_cast<int>(search_results.size()) - 1);
+        search_sel = keep_sel ? std::min(search_sel, last) : 0;
+        draw_search();
+    }
+
+    // Archives found by the library walk since the last batch
+    void merge_search_scan() {
+        std::vector<FileEntry> batch;
+        std::string error;
+        bool done = search_scan.take(batch, error);
+        search.add(batch, library);
+        if (done) search.finish();
+        if (searching) update_search(true);
+    }
+
+    void draw_search() {
+        list_view.valid = false;
+        clear_screen();
+        std::cout << "\033[1;1H";
+        std::cout << "Search: " << search_query << "\n";
+        if (config.show_help)
+            std::cout << "type to filter | ↑/↓ or Ctrl-N/P=move | Enter=open | Esc=cancel\n";
+        std::cout << "\n";
 
-        // Summary line
-        int comic_cnt = 0, folder_cnt = 0;
-        for (const auto& e : entries) {
-            if (e.is_directory && e.name != "..")
-                ++folder_cnt;
-            else if (!e.is_directory)
-                ++comic_cnt;
+        for (int i = 0; i < static_cast<int>(search_results.size()); ++i) {
+            const std::string& label = search.at(search_results[i].idx).label;
+            if (i == search_sel)
+                std::cout << "\033[7m► " << label << "\033[0m\n";
+            else
+                std::cout << "  " << label << "\n";
         }
-        std::cout << "\n" << folder_cnt << " folders, " << comic_cnt
-                  << " comics\n";
+        std::cout << "\n" << search.match_count() << " of " << search.size()
+                  << " comics (" << strfmt("%.1f", search_ms) << " ms"
+                  << (search_scan.running() ? ", indexing…" : "") << ")\n";
         std::cout << std::flush;
     }
 
+    // Jump the browser to the chosen archive and open it
+    void open_search_result() {
+        searching = false;
+        if (search_results.empty()) {
+            draw_file_list();
+            return;
+        }
+        FileEntry fe;
+        fe.full_path = search.at(search_results[search_sel].idx).path;
+        fe.name = fs::path(fe.full_path).filename().string();
+        fe.is_directory = false;
+        current_dir = fs::path(fe.full_path).parent_path().string();
+        scan_directory(fe.full_path);
+        open_comic(fe);
+    }
+
+    void handle_search_key(char c) {
+        int last = static_cast<int>(search_results.size()) - 1;
+        if (c == '\033') {
+            char seq[2];
+            // An arrow key's bytes follow within a few ms; a lone Esc
+            // is one that nothing follows for 50 ms
+            if (!input_pending(50) || read(STDIN_FILENO, &seq[0], 1) != 1) {
+                searching = false;   // plain Esc
+                draw_file_list();
+                return;
+            }
+            if (read(STDIN_FILENO, &seq[1], 1) != 1 || seq[0] != '[') return;
+            if (seq[1] == 'A') c = 16;
+            else if (seq[1] == 'B') c = 14;
+            else return;
+        }
+        if (c == 16 || c == 14) {            // Ctrl‑P / Ctrl‑N
+            search_sel = std::clamp(search_sel + (c == 14 ? 1 : -1), 0, std::max(0, last));
+            draw_search();
+        } else if (c == '\r' || c == '\n') {
+            open_search_result();
+        } else if (c == 127 || c == 8) {
+            if (search_query.empty()) return;
+            search_query.pop_back();
+            update_search();
+        } else if (static_cast<unsigned char>(c) >= 32) {
+            search_query += c;
+            update_search();
+        }
+    }
+
     // ------------------------------------------------------------------
-    // UI: comic‑view (single page or double‑page spread)
+    // Which pages a view starting at `first` shows, and where
     // ------------------------------------------------------------------
-    void draw_comic_view() {
-        clear_screen();
+    struct ViewSlot {
+        int page;
+        int col_offset;     // in character cells
+        int width_px;       // 0 = full width
+    };
+
+    // A page that fills a spread on its own. ComicInfo.xml page hints are
+    // authoritative when the archive has them; otherwise landscape pages
+    // are spreads. Only dimensions already known count (page index,
+    // decoded pages): reading a header here would extract the page – and
+    // in a solid RAR everything before it – just to lay out a view, so an
+    // unknown page is taken as portrait until it is decoded.
+    bool is_spread(int page_idx) {
+        const ComicInfo& info = archive.comic_info();
+        if (info.has_pages) return info.double_pages.count(page_idx) > 0;
+        auto it = page_dims_cache.find(page_idx);
+        return it != page_dims_cache.end() && it->second.first > it->second.second;
+    }
+
+    bool shown_alone(int page_idx) {
+        return archive.comic_info().covers.count(page_idx) > 0 || is_spread(page_idx);
+    }
+
+    std::vector<ViewSlot> view_slots(int first) {
+        int count = static_cast<int>(archive.page_count());
+        if (first < 0 || first >= count) return {};
 
         bool effective_double = config.double_page &&
                                std::abs(zoom_level - 1.0f) < 0.001f &&
                                (config.render_mode == RenderMode::KITTY ||
+                                config.render_mode == RenderMode::ITERM2 ||
                                 config.render_mode == RenderMode::TIMG);
-        if (effective_double && current_page + 1 < static_cast<int>(archive.page_count())) {
-            // Double‑page spread (only when not zoomed and in KITTY or TIMG mode)
-            auto p1 = load_page(current_page);
-            auto p2 = load_page(current_page + 1);
-
+        if (effective_double && first + 1 < count &&
+            !shown_alone(first) && !shown_alone(first + 1)) {
+            // Double‑page spread (only when not zoomed and in a pixel/timg mode)
             TermSize term = get_term_size();
             int half_cols = term.cols / 2;
             int half_px   = term.pixel_width / 2;
+            return { { first, 0, half_px }, { first + 1, half_cols, half_px } };
+        }
+        // Single page (or zoomed view)
+        return { { first, 0, 0 } };
+    }
 
-            if (!p1.empty())
-                display_image(p1, 0, half_px);
-            if (!p2.empty())
-                display_image(p2, half_cols, half_px);
-        } else {
-            // Single page (or zoomed view)
-            auto page = load_page(current_page);
-            if (!page.empty())
-                display_image(page, 0, 0);
+    // First page of the view after / before the one starting at `first`
+    int next_view(int first) {
+        return first + std::max<int>(1, static_cast<int>(view_slots(first).size()));
+    }
+
+    int prev_view(int first) {
+        if (first <= 0) return 0;
+        return (first >= 2 && view_slots(first - 2).size() == 2) ? first - 2 : first - 1;
+    }
+
+    // ------------------------------------------------------------------
+    // UI: comic‑view (single page or double‑page spread)
+    // ------------------------------------------------------------------
+    void draw_comic_view() {
+        list_view.valid = false;
+        view_extract.clear();
+        // Abandon whatever the previous view was still sending, except a
+        // pre‑transmission that is bringing one of the pages we need now
+        for (uint32_t id : out.abandon(kitty_ids_for_view()))
+            kitty_images.erase_id(id);
+
+        out.push("\033[2J\033[H");
+        page_stats = PageStats{};
+        page_stats.start = std::chrono::steady_clock::now();
+        if (config.render_mode == RenderMode::KITTY) {
+            // Drop the previous placements (ours only – d=a would also take
+            // other programs' images); the image data stays resident
+            for (uint32_t id : kitty_on_screen)
+                out.push(strfmt("\033_Ga=d,d=i,i=%u,q=2\033\\", id));
+            kitty_on_screen.clear();
+        }
+
+        view_events.clear();
+        std::vector<ViewSlot> slots = view_slots(current_page);
+        for (const ViewSlot& slot : slots) {
+            PageEvent e;
+            e.page = slot.page;
+            if (telemetry.enabled()) tel = &e;
+            display_image(slot.page, slot.col_offset, slot.width_px);
+            tel = nullptr;
+            if (!telemetry.enabled()) continue;
+            e.extract_ms = view_extract[slot.page];
+            view_events.push_back(e);
+        }
+        // A page decoded just now turned out to be a spread: lay out again
+        // (its dimensions are known from here on, so this happens once)
+        if (view_slots(current_page).size() != slots.size()) {
+            draw_comic_view();
+            return;
         }
 
-        // Status line (bottom of the screen)
+        draw_status_line();
+
+        // Save progress
+        Progress p;
+        p.page = current_page;
+        p.total = static_cast<int>(archive.page_count());
+        p.last_read = static_cast<int64_t>(time(nullptr));
+        p.completed = current_page + static_cast<int>(view_slots(current_page).size()) >= p.total;
+        progress.put(archive_id, p);
+
+        // Pre‑load neighbours for smoother paging, and the next comic when
+        // we are close to the end of this one
+        preload_adjacent();
+        prefetch_next_comic();
+        idle_work = config.render_mode == RenderMode::KITTY || !unsaved_renders.empty();
+    }
+
+    // Status line (bottom of the screen)
+    void draw_status_line() {
+        if (!config.show_help) return;
         TermSize term = get_term_size();
-        std::cout << "\033[" << term.rows << ";1H\033[K";
+        std::ostringstream line;
+        line << "\033[" << term.rows << ";1H\033[K";
 
-        if (config.show_help) {
-            if (config.double_page) {
-                std::cout << "Pages " << (current_page + 1) << "-"
-                          << std::min(current_page + 2,
-                                      static_cast<int>(archive.page_count()))
-                          << "/" << archive.page_count();
-            } else {
-                std::cout << "Page " << (current_page + 1) << "/"
-                          << archive.page_count();
+        if (view_slots(current_page).size() == 2) {
+            line << "Pages " << (current_page + 1) << "-" << (current_page + 2)
+                 << "/" << archive.page_count();
+        } else {
+            line << "Page " << (current_page + 1) << "/"
+                 << archive.page_count();
+        }
+        if (page_stats.done)
+            line << " | " << page_stats.bytes / 1024 << " KB in "
+                 << static_cast<int>(page_stats.ms) << " ms";
+        else
+            line << " | sending " << page_stats.bytes / 1024 << " KB";
+        if (out.throughput.rate() > 0)
+            line << " @ " << static_cast<int>(out.throughput.rate() / 1024) << " KB/s";
+        line << " | Zoom: " << static_cast<int>(zoom_level * 100)
+             << "% | Shift+=/Shift-=zoom | 0=reset | arrows/hjkl=nav | Shift+arrows/HJKL=pan | s=spread | q=back";
+        out.push(line.str());
+    }
+
+    // The view is fully sent: whatever time was not spent extracting,
+    // decoding or scaling went to emitting it. Views abandoned by a
+    // quicker page turn are not logged.
+    void log_view() {
+        double work = 0;
+        for (const PageEvent& e : view_events) work += e.extract_ms + e.decode_ms + e.resize_ms;
+        for (PageEvent& e : view_events) {
+            e.emit_ms = std::max(0.0, page_stats.ms - work);
+            telemetry.page(tel_archive, e);
+            ++tel_session.pages;
+            tel_session.bytes += e.bytes;
+        }
+        view_events.clear();
+    }
+
+    // Work done only while nothing is being sent and no key is waiting
+    void run_idle_work() {
+        idle_work = false;
+        in_idle_work = true;
+        while (!unsaved_renders.empty() && !input_pending()) {
+            const UnsavedRender& r = unsaved_renders.front();
+            render_cache.store(r.name, r.w, r.h, r.pixels, r.channels);
+            unsaved_renders.pop_front();
+        }
+        if (config.render_mode == RenderMode::KITTY) {
+            pretransmit_neighbours();
+            kitty_evict();
+        }
+        in_idle_work = false;
+    }
+
+    // ------------------------------------------------------------------
+    // Block until a key arrives, writing queued output as the terminal
+    // accepts it and running idle work once everything is out.
+    // Returns false when stdin is closed.
+    // ------------------------------------------------------------------
+    bool wait_for_input() {
+        while (true) {
+            struct pollfd fds[4] = {
+                { STDIN_FILENO, POLLIN, 0 },
+                { STDOUT_FILENO, static_cast<short>(out.pending() ? POLLOUT : 0), 0 },
+                { scanner.fd(), POLLIN, 0 },
+                { search_scan.fd(), POLLIN, 0 },
+            };
+            // Wake once a directory scan has been running long enough to
+            // deserve a "scanning…" note
+            int timeout = -1;
+            if (scanner.running() && !scan_slow)
+                timeout = std::max(0, scan_slow_ms - static_cast<int>(scanner.elapsed_ms()));
+            // …and to refine a reduced preview once keys have paused
+            bool refine = viewing_comic && page_stats.done && !out.pending() && refine_due();
+            if (refine) {
+                int left = std::max(0, refine_quiet_ms - static_cast<int>(ms_since(quiet_since)));
+                timeout = timeout < 0 ? left : std::min(timeout, left);
+            }
+            int n = poll(fds, 4, timeout);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0 && scanner.running() && !scan_slow &&
+                scanner.elapsed_ms() >= scan_slow_ms) {
+                scan_slow = true;
+                if (!viewing_comic && !searching) repaint_file_list();
+                continue;
+            }
+            if (n == 0 && refine && ms_since(quiet_since) >= refine_quiet_ms) {
+                in_idle_work = true;
+                refine_on_screen();
+                in_idle_work = false;
+                continue;
+            }
+            if (fds[1].revents & POLLOUT) out.pump();
+            if (fds[2].revents & POLLIN) merge_scan();
+            if (fds[3].revents & POLLIN) merge_search_scan();
+
+            if (!out.pending() && viewing_comic && !page_stats.done) {
+                // Everything for this view is out – record what it cost
+                page_stats.ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - page_stats.start).count();
+                page_stats.done = true;
+                quiet_since = std::chrono::steady_clock::now();
+                log_view();
+                draw_status_line();
+                continue;
             }
-            std::cout << " | Zoom: " << static_cast<int>(zoom_level * 100)
-                      << "% | Shift+=/Shift-=zoom | 0=reset | arrows/hjkl=nav | Shift+arrows/HJKL=pan | s=spread | q=back";
+            if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) return true;
+            if (!out.pending() && idle_work) run_idle_work();
         }
-        std::cout << std::flush;
+    }
 
-        // Save progress
-        progress.data[current_comic_filename] = current_page;
-        progress.save(progress_path);
+    // Open an archive from the browser and show its saved page. On a
+    // roll‑over the archive may already be open (prefetched); a finished
+    // comic is then started from the beginning.
+    void open_comic(const FileEntry& fe, bool from_browser = true) {
+        bool opened = !from_browser && archive.page_count() > 0;
+        uint64_t fp = archive_fingerprint(fe.full_path);
+
+        // A cached page index spares the walk over the archive's headers
+        PageIndex idx;
+        bool indexed = !daemon.connected() && page_index.load(fp, idx);
+        if (indexed && !opened) {
+            archive.open_indexed(fe.full_path, idx);
+        } else if (!opened && !archive.open(fe.full_path)) {
+            std::cout << "\n[Failed to open archive]\n";
+            std::fflush(stdout);
+            sleep(1);
+            draw_file_list();
+            return;
+        }
+        index_dims = 0;
+        for (size_t i = 0; i < idx.dims.size(); ++i)
+            if (idx.dims[i].first > 0) {
+                page_dims_cache[static_cast<int>(i)] = idx.dims[i];
+                ++index_dims;
+            }
+        if (!indexed && !archive.is_remote()) save_page_index(fp);
+
+        viewing_comic = true;
+        archive_path_open = fe.full_path;
+        archive_id = fp;
+        library.update(archive_id, fe.full_path, archive.comic_info(),
+                       static_cast<int>(archive.page_count()));
+        current_comic_filename = fe.name;
+        tel_archive = TelemetryLog::archive(archive_id, fe.full_path, config.render_mode);
+        tel_session = {};
+        tel_session.start = std::chrono::steady_clock::now();
+        zoom_level = 1.0f;
+        pan_x = pan_y = 0;
+
+        // Restore saved page if we have one
+        Progress saved;
+        if (progress.get(archive_id, path_identity(fe.full_path),
+                         current_comic_filename, saved) &&
+            (from_browser || !saved.completed)) {
+            current_page = saved.page;
+            if (current_page >= static_cast<int>(archive.page_count()))
+                current_page = 0;
+        } else {
+            current_page = 0;
+        }
+        draw_comic_view();
+    }
 
-        // Pre‑load neighbours for smoother paging
-        preload_adjacent();
+    // Store the page list and every page size learned so far
+    void save_page_index(uint64_t fp) {
+        PageIndex idx;
+        idx.pages = archive.get_entries();
+        idx.info = archive.comic_info();
+        idx.dims.resize(idx.pages.size());
+        for (const auto& [page, wh] : page_dims_cache)
+            if (page < static_cast<int>(idx.dims.size())) idx.dims[page] = wh;
+        page_index.store(fp, idx);
+        index_dims = page_dims_cache.size();
+    }
+
+    // Leave the comic view and release everything tied to the archive
+    void close_comic() {
+        if (viewing_comic && !archive.is_remote() && page_dims_cache.size() > index_dims)
+            save_page_index(archive_id);
+        if (viewing_comic)
+            telemetry.session(tel_archive, tel_session.pages,
+                              ms_since(tel_session.start) / 1000, tel_session.bytes);
+        view_events.clear();
+        for (uint32_t id : out.abandon()) kitty_images.erase_id(id);
+        viewing_comic = false;
+        idle_work = false;
+        need_redraw = false;
+        archive.close();
+        cancel_next_comic();
+        page_cache.clear();
+        predecoded.clear();
+        descreened.clear();
+        page_dims_cache.clear();
+        kitty_delete(kitty_images.clear());
+        kitty_on_screen.clear();
+        out.drain();
     }
 
 public:
@@ -773,9 +5423,23 @@ public:
         std::string home = getenv("HOME") ? getenv("HOME") : "";
         if (!home.empty()) {
             config.load(home + "/.tcreader.conf");
-            progress_path = home + "/.tcreader_progress.json";
-            progress.load(progress_path);
+            progress.open(home + "/.tcreader_progress.log",
+                          home + "/.tcreader_progress.json");
         }
+        if (config.use_daemon && daemon.connect(true))
+            archive.use_daemon(&daemon);
+        if (config.shared_cache)
+            shared_cache.open(shared_cache_path(), config.shared_cache_mb << 20);
+        if (!cache_dir().empty())
+            library.open(cache_dir() + "/library");
+        library_roots = config.library_paths;
+        if (library_roots.empty()) library_roots.push_back(initial_dir);
+        if (config.render_cache && !cache_dir().empty())
+            render_cache.open(cache_dir() + "/renders", config.render_cache_mb << 20);
+        if (!cache_dir().empty())
+            page_index.open(cache_dir() + "/index");
+        if (config.telemetry && !cache_dir().empty())
+            telemetry.open(cache_dir() + "/telemetry.tsv");
         scan_directory();
     }
 
@@ -784,18 +5448,29 @@ public:
     // ------------------------------------------------------------------
     void run() {
         enable_raw_mode();
+        detect_terminal();
         draw_file_list();
 
         char c;
-        while (read(STDIN_FILENO, &c, 1) == 1) {
+        while (wait_for_input() && read(STDIN_FILENO, &c, 1) == 1) {
             // ------------------------------------------------------------
             // 1️⃣  LIST BROWSER (not currently viewing a comic)
             // ------------------------------------------------------------
             if (!viewing_comic) {
+                if (searching) {
+                    handle_search_key(c);
+                    continue;
+                }
                 if (c == config.keymap["quit"][0]) break;
 
+                else if (c == config.keymap["search"][0]) {
+                    searching = true;
+                    search_query.clear();
+                    update_search();
+                }
+
                 else if (c == config.keymap["refresh"][0]) {
-                    scan_directory();
+                    scan_directory(entries.empty() ? "" : entries[selected_idx].full_path);
                     draw_file_list();
                 }
 
@@ -806,38 +5481,43 @@ public:
 
                 else if (c == config.keymap["first_page"][0]) {
                     selected_idx = 0;
-                    draw_file_list();
+                    update_file_list();
                 }
 
                 else if (c == config.keymap["last_page"][0]) {
-                    selected_idx = static_cast<int>(entries.size()) - 1;
-                    draw_file_list();
+                    selected_idx = std::max(0, static_cast<int>(entries.size()) - 1);
+                    update_file_list();
                 }
 
                 else if (c == config.keymap["up"][0] && selected_idx > 0) {
                     --selected_idx;
-                    draw_file_list();
+                    update_file_list();
                 }
 
                 else if (c == config.keymap["down"][0] &&
                          selected_idx < static_cast<int>(entries.size()) - 1) {
                     ++selected_idx;
-                    draw_file_list();
+                    update_file_list();
                 }
 
-                else if (c == '\033') {          // Arrow keys (up/down)
-                    char seq[2];
+                else if (c == '\033') {          // Arrow keys, PgUp/PgDn
+                    char seq[3];
                     if (read(STDIN_FILENO, &seq[0], 1) != 1) continue;
                     if (read(STDIN_FILENO, &seq[1], 1) != 1) continue;
 
+                    int last = static_cast<int>(entries.size()) - 1;
                     if (seq[0] == '[') {
                         if (seq[1] == 'A' && selected_idx > 0) {
                             --selected_idx;
-                            draw_file_list();
-                        } else if (seq[1] == 'B' &&
-                                   selected_idx < static_cast<int>(entries.size()) - 1) {
+                            update_file_list();
+                        } else if (seq[1] == 'B' && selected_idx < last) {
                             ++selected_idx;
-                            draw_file_list();
+                            update_file_list();
+                        } else if ((seq[1] == '5' || seq[1] == '6') &&
+                                   read(STDIN_FILENO, &seq[2], 1) == 1 && seq[2] == '~') {
+                            int page = list_rows() * (seq[1] == '5' ? -1 : 1);
+                            selected_idx = std::clamp(selected_idx + page, 0, std::max(0, last));
+                            update_file_list();
                         }
                     }
                 }
@@ -851,32 +5531,10 @@ public:
                     if (fe.is_directory) {
                         // Change directory
                         current_dir = fe.full_path;
-                        selected_idx = 0;
                         scan_directory();
                         draw_file_list();
                     } else {
-                        // Try to open the archive
-                        if (archive.open(fe.full_path)) {
-                            viewing_comic = true;
-                            current_comic_filename = fe.name;
-                            zoom_level = 1.0f;
-                            pan_x = pan_y = 0;
-
-                            // Restore saved page if we have one
-                            if (progress.data.count(current_comic_filename)) {
-                                current_page = progress.data[current_comic_filename];
-                                if (current_page >= static_cast<int>(archive.page_count()))
-                                    current_page = 0;
-                            } else {
-                                current_page = 0;
-                            }
-                            draw_comic_view();
-                        } else {
-                            std::cout << "\n[Failed to open archive]\n";
-                            std::fflush(stdout);
-                            sleep(1);
-                            draw_file_list();
-                        }
+                        open_comic(fe);
                     }
                 }
 
@@ -885,7 +5543,7 @@ public:
                 // --------------------------------------------------------
             } else {
                 bool navigate = false;
-                int step = config.double_page ? 2 : 1;
+                int count = static_cast<int>(archive.page_count());
 
                 // ---- Helper: pan while zoomed (Shift + H/J/K/L or Shift + Arrows) ----
                 auto do_pan = [&](char dir) {
@@ -904,9 +5562,7 @@ public:
                     char seq[2];
                     if (read(STDIN_FILENO, &seq[0], 1) != 1) {
                         // Plain ESC → exit comic view
-                        viewing_comic = false;
-                        archive.close();
-                        page_cache.clear();
+                        close_comic();
                         draw_file_list();
                         continue;
                     }
@@ -934,22 +5590,27 @@ public:
                         }
 
                         // Plain arrows – page navigation (right/left)
-                        if (seq[1] == 'C' && current_page + step < static_cast<int>(archive.page_count())) {
-                            current_page += step;
+                        if (seq[1] == 'C' && next_view(current_page) < count) {
+                            current_page = next_view(current_page);
                             navigate = true;
+                        } else if (seq[1] == 'C' && roll_over()) {
+                            continue;
                         } else if (seq[1] == 'D' && current_page > 0) {
-                            current_page = std::max(0, current_page - step);
+                            current_page = prev_view(current_page);
                             navigate = true;
                         }
                     }
                 }
                 // ----- Regular keys (no ESC) -----
-                else if (c == config.keymap["next"][0] && current_page + step < static_cast<int>(archive.page_count())) {
-                    current_page += step;
+                else if (c == config.keymap["next"][0] && next_view(current_page) < count) {
+                    current_page = next_view(current_page);
                     navigate = true;
                 }
+                else if (c == config.keymap["next"][0]) {
+                    if (roll_over()) continue;
+                }
                 else if (c == config.keymap["prev"][0] && current_page > 0) {
-                    current_page = std::max(0, current_page - step);
+                    current_page = prev_view(current_page);
                     navigate = true;
                 }
                 else if (c == config.keymap["first_page"][0]) {
@@ -957,7 +5618,7 @@ public:
                     navigate = true;
                 }
                 else if (c == config.keymap["last_page"][0]) {
-                    current_page = static_cast<int>(archive.page_count()) - 1;
+                    current_page = count - 1;
                     navigate = true;
                 }
                 else if (c == config.keymap["toggle_spread"][0] || c == config.keymap["double_page"][0]) {
@@ -970,9 +5631,7 @@ public:
                 }
                 else if (c == config.keymap["quit"][0]) {
                     // Leave comic view, go back to file list
-                    viewing_comic = false;
-                    archive.close();
-                    page_cache.clear();
+                    close_comic();
                     draw_file_list();
                     continue;
                 }
@@ -1002,19 +5661,699 @@ public:
                     do_pan('L');
                 }
 
-                // If anything changed that requires a redraw, do it now
-                if (navigate) {
+                // If anything changed that requires a redraw, do it now –
+                // unless more keys are already queued (e.g. `l` pressed
+                // five times): then only the last one pays for a redraw
+                if (navigate) need_redraw = true;
+                if (need_redraw && !input_pending()) {
+                    need_redraw = false;
                     draw_comic_view();
                 }
             }
         }
 
         // Clean up terminal state before exiting
+        if (viewing_comic) close_comic();
         clear_screen();
         disable_raw_mode();
     }
 };
 
+// ------------------------------------------------------------------
+// `tcreader repack <file|dir>... [--png] [--delete] [--jobs N]`: rewrite
+// CBR, 7z and other non‑ZIP archives as stored (uncompressed) ZIPs with
+// the pages in natural order, so any page is one seek away instead of a
+// decompression from the start of a solid archive. Page bytes are copied
+// as they are; --png additionally re‑encodes PNG pages losslessly when
+// that makes them smaller (ZIPs are only rewritten for this). Files are
+// converted in parallel, each staged through an unlinked temporary file
+// so memory stays at one page per worker.
+// ------------------------------------------------------------------
+struct RepackResult {
+    enum { DONE, SKIPPED, FAILED } status = FAILED;
+    std::string message;
+    std::string output;
+    int pages = 0;
+    size_t in_bytes = 0, out_bytes = 0;
+};
+
+// Re‑encode a PNG with stronger filtering and compression. Only plain
+// 8‑bit images are touched: colour‑management chunks, 16‑bit samples or
+// animation would not survive the decode.
+static bool recompress_png(std::vector<unsigned char>& data) {
+    static const char* allowed[] = { "IHDR", "PLTE", "tRNS", "IDAT", "IEND", "pHYs", "tIME" };
+    if (data.size() < 8 || memcmp(data.data(), "\x89PNG\r\n\x1a\n", 8) != 0) return false;
+    for (size_t pos = 8; pos + 8 <= data.size();) {
+        uint32_t len = (uint32_t(data[pos]) << 24) | (data[pos + 1] << 16) |
+                       (data[pos + 2] << 8) | data[pos + 3];
+        std::string type(reinterpret_cast<const char*>(&data[pos + 4]), 4);
+        if (std::find(std::begin(allowed), std::end(allowed), type) == std::end(allowed))
+            return false;
+        pos += 12 + static_cast<size_t>(len);
+    }
+    int size = static_cast<int>(data.size());
+    if (stbi_is_16_bit_from_memory(data.data(), size)) return false;
+
+    int w, h, ch;
+    unsigned char* pixels = stbi_load_from_memory(data.data(), size, &w, &h, &ch, 0);
+    if (!pixels) return false;
+    std::vector<unsigned char> png = encode_png(pixels, w, h, ch, true);
+    stbi_image_free(pixels);
+    // Keep it only for a real gain (5 %)
+    if (png.empty() || png.size() * 20 > data.size() * 19) return false;
+    data.swap(png);
+    return true;
+}
+
+// X.cbr, X.cb7, X.zip … all become X.cbz
+static std::string repack_output(const std::string& path) {
+    fs::path in(path);
+    return (in.parent_path() / in.stem()).string() + ".cbz";
+}
+
+RepackResult repack_archive(const std::string& path, bool png, bool remove_original) {
+    RepackResult res;
+    fs::path in(path);
+    res.output = repack_output(path);
+    std::error_code ec;
+    res.in_bytes = fs::file_size(in, ec);
+    if (res.output != path && fs::exists(res.output, ec)) {
+        res.status = RepackResult::SKIPPED;
+        res.message = "output exists";
+        return res;
+    }
+
+    struct archive* a = archive_read_new();
+    archive_read_support_format_all(a);
+    archive_read_support_filter_all(a);
+    if (archive_read_open_filename(a, path.c_str(), 1 << 16) != ARCHIVE_OK) {
+        res.message = archive_error_string(a) ? archive_error_string(a) : "cannot open";
+        archive_read_free(a);
+        return res;
+    }
+
+    // Stage every page in one unlinked file next to the output, in archive
+    // order; it is written out in natural order afterwards
+    std::string dir = in.parent_path().empty() ? "." : in.parent_path().string();
+    int stage = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (stage < 0) {
+        std::string tmpl = dir + "/.tcreader-repack-XXXXXX";
+        stage = mkstemp(&tmpl[0]);
+        if (stage >= 0) unlink(tmpl.c_str());
+    }
+    if (stage < 0) {
+        archive_read_free(a);
+        res.message = "cannot create a temporary file";
+        return res;
+    }
+
+    struct Staged { std::string name; off_t offset; size_t size; };
+    std::vector<Staged> pages;
+    std::vector<Staged> info;          // ComicInfo.xml, written first
+    std::vector<Staged> other;         // other files, kept in archive order
+    int dropped = 0;                   // entries that are not regular files
+    off_t end = 0;
+    bool is_zip = false, changed = false, checked_format = false;
+    struct archive_entry* entry;
+    int r;
+    while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+        if (!checked_format) {
+            checked_format = true;
+            is_zip = (archive_format(a) & ARCHIVE_FORMAT_BASE_MASK) == ARCHIVE_FORMAT_ZIP;
+            if (is_zip && !png) break;   // already random access
+        }
+        if (archive_entry_is_encrypted(entry)) {
+            res.status = RepackResult::SKIPPED;
+            res.message = "encrypted";
+            break;
+        }
+        if (archive_entry_filetype(entry) != AE_IFREG) {
+            if (archive_entry_filetype(entry) != AE_IFDIR) ++dropped;
+            continue;
+        }
+        std::string name = archive_entry_pathname(entry);
+        std::string ext = fs::path(name).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        std::string base = fs::path(name).filename().string();
+        std::transform(base.begin(), base.end(), base.begin(), ::tolower);
+        bool image = ext == ".jpg" || ext == ".jpeg" || ext == ".png" ||
+                     ext == ".gif" || ext == ".webp" || ext == ".bmp";
+
+        std::vector<unsigned char> data;
+        unsigned char buf[1 << 16];
+        ssize_t got;
+        while ((got = archive_read_data(a, buf, sizeof(buf))) > 0)
+            data.insert(data.end(), buf, buf + got);
+        if (got < 0) {
+            r = ARCHIVE_FATAL;
+            break;
+        }
+        if (png && ext == ".png" && recompress_png(data)) changed = true;
+
+        std::vector<Staged>& group = image ? pages : base == "comicinfo.xml" ? info : other;
+        group.push_back({ name, end, data.size() });
+        if (pwrite(stage, data.data(), data.size(), end) != static_cast<ssize_t>(data.size())) {
+            r = ARCHIVE_FATAL;
+            break;
+        }
+        end += data.size();
+    }
+    if (r != ARCHIVE_OK && r != ARCHIVE_EOF && res.message.empty())
+        res.message = archive_error_string(a) ? archive_error_string(a) : "read error";
+    archive_read_free(a);
+
+    if (!res.message.empty() || (is_zip && !changed)) {
+        ::close(stage);
+        if (res.status == RepackResult::SKIPPED) return res;
+        if (res.message.empty()) {
+            res.status = RepackResult::SKIPPED;
+            res.message = png ? "already ZIP, no PNG gains" : "already ZIP";
+        }
+        return res;
+    }
+    if (pages.empty()) {
+        ::close(stage);
+        res.message = "no pages";
+        return res;
+    }
+    std::sort(pages.begin(), pages.end(), [](const Staged& x, const Staged& y) {
+        return natural_sort_compare(x.name, y.name);
+    });
+    size_t page_count = pages.size();
+    std::vector<Staged> entries = info;
+    entries.insert(entries.end(), pages.begin(), pages.end());
+    entries.insert(entries.end(), other.begin(), other.end());
+
+    // Write the stored ZIP under a temporary name of our own, then check it
+    size_t thread_tag = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string tmp_out = res.output + strfmt(".%d.%zu.tmp", static_cast<int>(getpid()), thread_tag);
+    int out_fd = ::open(tmp_out.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out_fd < 0) {
+        ::close(stage);
+        res.message = strfmt("cannot create %s: %s", tmp_out.c_str(), strerror(errno));
+        return res;
+    }
+    struct archive* w = archive_write_new();
+    archive_write_set_format_zip(w);
+    archive_write_zip_set_compression_store(w);
+    bool ok = archive_write_open_fd(w, out_fd) == ARCHIVE_OK;
+    std::vector<unsigned char> data;
+    for (const Staged& pg : entries) {
+        if (!ok) break;
+        data.resize(pg.size);
+        ok = pread(stage, data.data(), pg.size, pg.offset) == static_cast<ssize_t>(pg.size);
+        struct archive_entry* e = archive_entry_new();
+        archive_entry_set_pathname(e, pg.name.c_str());
+        archive_entry_set_size(e, static_cast<int64_t>(pg.size));
+        archive_entry_set_filetype(e, AE_IFREG);
+        archive_entry_set_perm(e, 0644);
+        archive_entry_set_mtime(e, time(nullptr), 0);
+        ok = ok && archive_write_header(w, e) == ARCHIVE_OK &&
+             archive_write_data(w, data.data(), pg.size) == static_cast<ssize_t>(pg.size);
+        archive_entry_free(e);
+    }
+    if (!ok && archive_error_string(w)) res.message = archive_error_string(w);
+    ok = archive_write_close(w) == ARCHIVE_OK && ok;
+    archive_write_free(w);
+    ok = ::close(out_fd) == 0 && ok;
+    ::close(stage);
+
+    // Same pages, and every staged file back with its size
+    ArchiveReader check;
+    ok = ok && check.open_local(tmp_out) && check.page_count() == page_count;
+    check.close();
+    if (ok) {
+        std::map<std::string, size_t> want, got;
+        for (const Staged& e : entries) want[e.name] = e.size;
+        struct archive* v = archive_read_new();
+        archive_read_support_format_zip(v);
+        ok = archive_read_open_filename(v, tmp_out.c_str(), 1 << 16) == ARCHIVE_OK;
+        while (ok && archive_read_next_header(v, &entry) == ARCHIVE_OK)
+            got[archive_entry_pathname(entry)] = static_cast<size_t>(archive_entry_size(entry));
+        archive_read_free(v);
+        ok = ok && got == want;
+    }
+    if (!ok) {
+        unlink(tmp_out.c_str());
+        if (res.message.empty()) res.message = "write failed";
+        return res;
+    }
+
+    // A new name must not replace a file that appeared meanwhile; link()
+    // fails if it exists. Rewriting a ZIP in place replaces it on purpose.
+    bool placed = res.output == path ? rename(tmp_out.c_str(), res.output.c_str()) == 0
+                                     : link(tmp_out.c_str(), res.output.c_str()) == 0;
+    int err = errno;
+    unlink(tmp_out.c_str());
+    if (!placed) {
+        res.message = strerror(err);
+        return res;
+    }
+    if (remove_original && res.output != path) {
+        if (dropped)
+            res.message = strfmt("original kept, %d non-file entries not copied", dropped);
+        else
+            unlink(path.c_str());
+    }
+
+    res.status = RepackResult::DONE;
+    res.pages = static_cast<int>(page_count);
+    res.out_bytes = fs::file_size(res.output, ec);
+    return res;
+}
+
+int run_repack(int argc, char* argv[]) {
+    bool png = false, remove_original = false;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+    auto is_archive = [](const fs::path& p) {
+        std::string ext = p.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        return ext == ".cbr" || ext == ".rar" || ext == ".cb7" || ext == ".7z" ||
+               ext == ".cbz" || ext == ".zip" || ext == ".cbt" || ext == ".tar";
+    };
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::error_code ec;
+        if (arg == "--png") {
+            png = true;
+        } else if (arg == "--delete") {
+            remove_original = true;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (fs::is_directory(arg, ec)) {
+            fs::recursive_directory_iterator it(arg, fs::directory_options::skip_permission_denied, ec), end;
+            for (; !ec && it != end; it.increment(ec))
+                if (it->is_regular_file(ec) && is_archive(it->path()))
+                    files.push_back(it->path().string());
+        } else if (fs::is_regular_file(arg, ec)) {
+            files.push_back(arg);
+        } else {
+            std::cerr << "Not found: " << arg << "\n";
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "Usage: tcreader repack <file|directory>... [--png] [--delete] [--jobs N]\n"
+                  << "Rewrites CBR/7z archives as stored CBZ files (pages unchanged).\n";
+        return 1;
+    }
+    std::sort(files.begin(), files.end(), natural_sort_compare);
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    // Inputs that would write the same CBZ (X.cbr and X.cb7, or X.zip and
+    // X.cbz with --png) are left alone: which one should win is not ours to guess
+    std::map<std::string, std::vector<std::string>> by_output;
+    for (const std::string& f : files) by_output[repack_output(f)].push_back(f);
+    std::vector<std::string> unique;
+    for (const std::string& f : files) {
+        const std::vector<std::string>& same = by_output[repack_output(f)];
+        if (same.size() == 1) {
+            unique.push_back(f);
+            continue;
+        }
+        std::cout << f << ": skipped, " << fs::path(repack_output(f)).filename().string()
+                  << " would also be written from";
+        for (const std::string& o : same)
+            if (o != f) std::cout << " " << fs::path(o).filename().string();
+        std::cout << "\n";
+    }
+    files.swap(unique);
+
+    std::mutex print_lock;
+    std::atomic<size_t> next{ 0 };
+    std::atomic<int> converted{ 0 }, failed{ 0 };
+    std::vector<std::thread> workers;
+    for (unsigned j = 0; j < std::min<size_t>(jobs, files.size()); ++j)
+        workers.emplace_back([&] {
+            for (size_t i; (i = next++) < files.size();) {
+                RepackResult res = repack_archive(files[i], png, remove_original);
+                std::lock_guard<std::mutex> lock(print_lock);
+                if (res.status == RepackResult::DONE) {
+                    ++converted;
+                    std::cout << files[i] << " -> " << fs::path(res.output).filename().string()
+                              << strfmt(" (%d pages, %.1f MB -> %.1f MB)", res.pages,
+                                        res.in_bytes / 1048576.0, res.out_bytes / 1048576.0)
+                              << (res.message.empty() ? "" : ", " + res.message) << "\n";
+                } else if (res.status == RepackResult::SKIPPED) {
+                    std::cout << files[i] << ": skipped, " << res.message << "\n";
+                } else {
+                    ++failed;
+                    std::cout << files[i] << ": failed, " << res.message << "\n";
+                }
+            }
+        });
+    for (std::thread& t : workers) t.join();
+    std::cout << converted << " converted, " << failed << " failed\n";
+    return failed ? 1 : 0;
+}
+
+// `tcreader --kernels`: the variant each kernel uses, of those built in
+int run_kernels() {
+    auto row = [](const char* name, const char* active, std::vector<std::string> built) {
+        std::string list;
+        for (const std::string& isa : built)
+            list += (list.empty() ? "" : " ") + isa + (kern::cpu_has(isa) ? "" : "(n/a)");
+        std::cout << strfmt("%-16s %-10s built: %s\n", name, active, list.c_str());
+    };
+    auto isas = [](const auto& variants) {
+        std::vector<std::string> out;
+        for (const auto& v : variants) out.push_back(v.isa);
+        return out;
+    };
+    const Kernels& k = kernels();
+    row("descreen taps", k.tap.isa, isas(kern::tap_variants));
+    row("base64", k.base64.isa, isas(kern::base64_variants));
+    row("palette search", k.nearest.isa, isas(kern::nearest_variants));
+    row("resize (stb)", kern::resize_isa(), { kern::resize_isa() });
+    return 0;
+}
+
+// ------------------------------------------------------------------
+// `tcreader --selftest`: check the hand-written formats against known
+// answers – XXH64 (archive fingerprints) on the reference test vectors,
+// QOI round trips through every opcode and the grayscale path, and the
+// progress log dropping a record whose CRC does not match.
+// ------------------------------------------------------------------
+int run_selftest() {
+    int failed = 0;
+    auto check = [&](const std::string& name, bool ok) {
+        std::cout << (ok ? "ok    " : "FAIL  ") << name << "\n";
+        if (!ok) ++failed;
+    };
+
+    const struct { const char* text; uint64_t seed, hash; } vectors[] = {
+        { "", 0, 0xEF46DB3751D8E999ull },
+        { "a", 0, 0xD24EC4F1A98C6E5Bull },
+        { "abc", 0, 0x44BC2CF5AD770999ull },
+        { "Nobody inspects the spammish repetition", 0, 0xFBCEA83C8A378BF1ull },
+        { "xxhash", 20141025, 0xB559B98D844E0635ull },
+    };
+    for (const auto& v : vectors)
+        check(strfmt("xxh64 \"%.12s\" seed %llu", v.text,
+                     static_cast<unsigned long long>(v.seed)),
+              xxh64(v.text, strlen(v.text), v.seed) == v.hash);
+
+    // A flat run longer than one QOI run op, small steps (DIFF), larger
+    // ones (LUMA), a repeat of an earlier colour (INDEX) and noise (RGB)
+    const int w = 97, h = 7;
+    std::vector<unsigned char> rgb(w * h * 3), gray(w * h);
+    uint32_t noise = 12345;
+    for (int i = 0; i < w * h; ++i) {
+        noise = noise * 1103515245u + 12345u;
+        int x = i % w, y = i / w;
+        int v = y < 2    ? 40              // runs
+              : y == 2   ? x               // diff
+              : y == 3   ? x * 9           // luma
+              : y == 4   ? x % 3 * 80      // index
+              : static_cast<int>(noise >> 24);   // rgb
+        rgb[i * 3] = static_cast<unsigned char>(v);
+        rgb[i * 3 + 1] = static_cast<unsigned char>(y == 5 ? noise >> 16 : v);
+        rgb[i * 3 + 2] = static_cast<unsigned char>(v ^ (y == 6 ? noise >> 8 : 0));
+        gray[i] = static_cast<unsigned char>(v);
+    }
+    std::vector<unsigned char> back;
+    std::vector<unsigned char> packed = encode_qoi(rgb.data(), w, h, 3);
+    check("qoi rgb round trip", decode_qoi(packed.data(), packed.size(), w, h, back, 3) &&
+                                back == rgb);
+    packed = encode_qoi(gray.data(), w, h, 1);
+    check("qoi gray round trip", decode_qoi(packed.data(), packed.size(), w, h, back, 1) &&
+                                 back == gray);
+    check("qoi rejects a wrong size", !decode_qoi(packed.data(), packed.size(), w + 1, h,
+                                                  back, 1));
+
+    // Two records for one comic, then a torn write of the newer one: the
+    // log must fall back to the older record
+    char tmpl[] = "/tmp/tcreader-selftest-XXXXXX";
+    if (!mkdtemp(tmpl)) {
+        check("progress log (no temporary directory)", false);
+        return 1;
+    }
+    std::string log = std::string(tmpl) + "/progress.log";
+    const uint64_t key = 0x1234;
+    {
+        ProgressStore store;
+        store.open(log, "");
+        store.put(key, Progress{ 5, 20, 1000, false });
+        store.put(key, Progress{ 7, 20, 1001, false });
+    }
+    Progress p;
+    {
+        ProgressStore store;
+        store.open(log, "");
+        check("progress log round trip", store.get(key, 0, "", p) && p.page == 7 &&
+                                         p.total == 20 && p.last_read == 1001);
+    }
+    int fd = ::open(log.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0) {
+        unsigned char b = 0;
+        off_t at = st.st_size - 32 + 16;    // page field of the last record
+        if (pread(fd, &b, 1, at) == 1) {
+            b ^= 0x40;
+            if (pwrite(fd, &b, 1, at) != 1) b = 0;
+        }
+    }
+    if (fd >= 0) ::close(fd);
+    {
+        ProgressStore store;
+        store.open(log, "");
+        check("progress log drops a bad crc", store.get(key, 0, "", p) && p.page == 5);
+    }
+    unlink(log.c_str());
+    rmdir(tmpl);
+
+    std::cout << (failed ? strfmt("%d failed\n", failed) : "all passed\n");
+    return failed ? 1 : 0;
+}
+
+// ------------------------------------------------------------------
+// `tcreader warm <dir> [--size WxH] [--jobs N]`: fill the caches a first
+// open would otherwise build, for every archive under <dir> – the
+// fingerprint, the page index with header dimensions and the library
+// metadata, plus with --size (the terminal's size in pixels) the scaled
+// pages in the render cache. A walker feeds a bounded queue, so memory
+// stays flat however large the library is; one worker per core drains it.
+// ------------------------------------------------------------------
+int run_warm(int argc, char* argv[], const Config& cfg) {
+    std::string root;
+    int size_w = 0, size_h = 0;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &size_w, &size_h) != 2 ||
+                size_w <= 0 || size_h <= status_line_px)
+                size_w = size_h = -1;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            root = arg;
+        }
+    }
+    std::error_code ec;
+    if (root.empty() || size_w < 0 || !fs::is_directory(root, ec)) {
+        std::cerr << "Usage: tcreader warm <directory> [--size WIDTHxHEIGHT] [--jobs N]\n";
+        return 1;
+    }
+    std::string cache = cache_dir();
+    if (cache.empty()) {
+        std::cerr << "No cache directory (set HOME or XDG_CACHE_HOME)\n";
+        return 1;
+    }
+
+    PageIndexCache index;
+    index.open(cache + "/index");
+    LibraryIndex library;
+    library.open(cache + "/library");
+    RenderCache renders;
+    if (size_w > 0) renders.open(cache + "/renders", cfg.render_cache_mb << 20);
+
+    // Pixel boxes the reader will lay pages out in: the full terminal, and
+    // half of it for the pages of a spread
+    int box_h = size_h - status_line_px;
+    ResizeFilter filter = cfg.resize_filter;
+    int style = cfg.render_style();
+    std::mutex shared_lock;                  // library and render cache
+    std::atomic<size_t> found{ 0 }, done{ 0 }, pages{ 0 }, rendered{ 0 }, failed{ 0 };
+    std::atomic<bool> walked{ false };
+
+    // Renditions the reader will ask for: single pages, plus spread halves
+    auto boxes_for = [&](const PageIndex& idx, int page, int w, int h) {
+        std::vector<std::pair<int, int>> boxes;
+        if (size_w <= 0 || w <= 0) return boxes;
+        boxes.emplace_back(size_w, box_h);
+        bool alone = idx.info.covers.count(page) > 0 ||
+                     (idx.info.has_pages ? idx.info.double_pages.count(page) > 0 : w > h);
+        if (cfg.double_page && !alone) boxes.emplace_back(size_w / 2, box_h);
+        return boxes;
+    };
+
+    auto warm_archive = [&](const std::string& path) {
+        uint64_t fp = archive_fingerprint(path);
+        ArchiveReader reader;
+        PageIndex idx;
+        bool complete = index.load(fp, idx) &&
+                        std::none_of(idx.dims.begin(), idx.dims.end(),
+                                     [](const std::pair<int, int>& d) { return d.first == 0; });
+        if (complete) {
+            reader.open_indexed(path, idx);   // archive opened only if a render is missing
+        } else if (!fp || !reader.open_local(path)) {
+            ++failed;
+            return;
+        } else {
+            PageIndex fresh;
+            fresh.pages = reader.get_entries();
+            fresh.info = reader.comic_info();
+            fresh.dims.assign(fresh.pages.size(), { 0, 0 });
+            if (idx.dims.size() == fresh.dims.size()) fresh.dims = idx.dims;
+            idx = std::move(fresh);
+        }
+
+        // Read in archive order so the reader never rewinds
+        std::vector<size_t> order(idx.pages.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return idx.pages[a].index_in_archive < idx.pages[b].index_in_archive;
+        });
+
+        for (size_t i : order) {
+            int page = static_cast<int>(i);
+            auto& [w, h] = idx.dims[i];
+            bool missing = w == 0;
+            for (auto [bw, bh] : boxes_for(idx, page, w, h)) {
+                int nw, nh;
+                fit_page(w, h, bw, bh, 1.0f, nw, nh);
+                std::lock_guard<std::mutex> lock(shared_lock);
+                bool have = false;
+                for (int ch : { 1, 3 })
+                    have = have ||
+                           renders.contains(RenderCache::key(fp, page, nw, nh, 0, 0,
+                                                             nw, nh, ch, style));
+                if (!have) missing = true;
+            }
+            if (!missing) {
+                ++pages;
+                continue;
+            }
+
+            std::vector<unsigned char> data = reader.read_page(i);
+            int ch;
+            if (data.empty() ||
+                !stbi_info_from_memory(data.data(), static_cast<int>(data.size()), &w, &h, &ch))
+                continue;
+            ++pages;
+            if (size_w <= 0) continue;
+
+            DecodedPage decoded = decode_image(data, 0);
+            if (decoded.empty()) continue;
+            if (cfg.descreen) decoded = descreen_page(decoded);
+            for (auto [bw, bh] : boxes_for(idx, page, w, h)) {
+                int nw, nh;
+                fit_page(w, h, bw, bh, 1.0f, nw, nh);
+                int ch = decoded.channels;
+                std::string key = RenderCache::key(fp, page, nw, nh, 0, 0, nw, nh, ch, style);
+                {
+                    std::lock_guard<std::mutex> lock(shared_lock);
+                    if (renders.contains(key)) continue;
+                }
+                std::vector<unsigned char> resized(static_cast<size_t>(nw) * nh * ch);
+                resize_pixels(decoded.pixels.get(), decoded.w, decoded.h, resized.data(),
+                              nw, nh, ch, filter);
+                std::lock_guard<std::mutex> lock(shared_lock);
+                renders.store(key, nw, nh, resized, ch);
+                ++rendered;
+            }
+        }
+
+        index.store(fp, idx);
+        std::lock_guard<std::mutex> lock(shared_lock);
+        library.update(fp, path, idx.info, static_cast<int>(idx.pages.size()), false);
+    };
+
+    // Bounded queue between the directory walk and the workers
+    std::mutex queue_lock;
+    std::condition_variable have_work, have_room;
+    std::deque<std::string> queue;
+    const size_t queue_cap = jobs * 4;
+
+    std::thread walker([&] {
+        std::error_code wec;
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, wec), end;
+        for (; !wec && it != end; it.increment(wec)) {
+            std::error_code fec;
+            if (!it->is_regular_file(fec)) continue;
+            std::string ext = it->path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext != ".cbz" && ext != ".cbr" && ext != ".zip") continue;
+
+            std::unique_lock<std::mutex> lock(queue_lock);
+            have_room.wait(lock, [&] { return queue.size() < queue_cap; });
+            queue.push_back(it->path().string());
+            ++found;
+            have_work.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(queue_lock);
+        walked = true;
+        have_work.notify_all();
+    });
+
+    std::vector<std::thread> workers;
+    for (unsigned j = 0; j < jobs; ++j)
+        workers.emplace_back([&] {
+            while (true) {
+                std::string path;
+                {
+                    std::unique_lock<std::mutex> lock(queue_lock);
+                    have_work.wait(lock, [&] { return !queue.empty() || walked; });
+                    if (queue.empty()) return;
+                    path = std::move(queue.front());
+                    queue.pop_front();
+                    have_room.notify_one();
+                }
+                warm_archive(path);
+                ++done;
+            }
+        });
+
+    // Progress bar (only on a terminal)
+    auto start = std::chrono::steady_clock::now();
+    bool tty = isatty(STDERR_FILENO);
+    auto draw = [&] {
+        size_t total = found, finished = done;
+        const int width = 30;
+        int filled = total ? static_cast<int>(width * finished / total) : 0;
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "\r[" << std::string(filled, '#') << std::string(width - filled, '.') << "] "
+                  << finished << "/" << total << (walked ? "" : "+") << " archives, "
+                  << pages << " pages, " << rendered << " rendered, "
+                  << strfmt("%.1f s", secs) << "\033[K" << std::flush;
+    };
+    while (!(walked && done == found)) {
+        if (tty) draw();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    walker.join();
+    for (std::thread& t : workers) t.join();
+    if (tty) {
+        draw();
+        std::cerr << "\n";
+    }
+    library.flush();
+
+    std::cout << "Warmed " << done - failed << " archives (" << pages << " pages, "
+              << rendered << " new renditions)";
+    if (failed) std::cout << ", " << failed << " could not be opened";
+    std::cout << "\n";
+    if (size_w > 0) {
+        if (renders.size_bytes() + (64 << 20) > (cfg.render_cache_mb << 20))
+            std::cout << "The render cache is at its " << cfg.render_cache_mb
+                      << " MB budget; raise render_cache_mb to keep the whole library.\n";
+        if (!cfg.render_cache)
+            std::cout << "Set render_cache = true for the reader to use the renditions.\n";
+    }
+    return 0;
+}
+
 // ===================================================================
 //  main()
 // ===================================================================
@@ -1027,6 +6366,31 @@ int main(int argc, char* argv[]) {
     if (!home.empty())
         temp_cfg.load(home + "/.tcreader.conf");
 
+    // `tcreader stats [file]`: summarise the telemetry log
+    if (argc > 1 && std::string(argv[1]) == "stats")
+        return run_stats(argc > 2 ? argv[2] : cache_dir() + "/telemetry.tsv");
+
+    // `tcreader repack <files|dirs>`: convert to random‑access stored CBZ
+    if (argc > 1 && std::string(argv[1]) == "repack")
+        return run_repack(argc, argv);
+
+    // `tcreader warm <dir> [--size WxH]`: pre‑fill the caches for a library
+    if (argc > 1 && std::string(argv[1]) == "warm")
+        return run_warm(argc, argv, temp_cfg);
+
+    // `tcreader --kernels`: which SIMD variants this CPU uses
+    if (argc > 1 && std::string(argv[1]) == "--kernels")
+        return run_kernels();
+
+    // `tcreader --selftest`: known-answer checks of the built-in formats
+    if (argc > 1 && std::string(argv[1]) == "--selftest")
+        return run_selftest();
+
+    // Shared decode daemon: `tcreader --daemon`, or run as `tcreaderd`
+    if ((argc > 1 && std::string(argv[1]) == "--daemon") ||
+        fs::path(argv[0]).filename() == "tcreaderd")
+        return run_daemon(temp_cfg);
+
     if (argc > 1) {
         dir = argv[1];                     // explicit argument wins
     } else if (!temp_cfg.library_paths.empty()) {